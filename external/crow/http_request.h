@@ -49,6 +49,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
         void* middleware_context{};
         void* middleware_container{};
         asio::io_context* io_context{};
+        const std::string* route{}; ///< Pattern of the matched rule, e.g. "/students/<int>/grades" (set by the router, nullptr if no rule matched).
 
         /// Construct an empty request. (sets the method to `GET`)
         request():
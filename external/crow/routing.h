@@ -1730,6 +1730,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
 
                     try {
                         BaseRule &rule = *rules[rule_index];
+                        req.route = &rule.rule();
                         handle_rule<App>(rule, req, res, found.r_params);
                     } catch (...) {
                         exception_handler_(res);
@@ -0,0 +1,458 @@
+#include "async_db.h"
+#include "queries.h"
+#include "query_stats.h"
+#include <iostream>
+#include <stdexcept>
+#include <unordered_set>
+
+// ----------------- PgResult -----------------
+
+int PgResult::column(const char *name) const {
+    int col = PQfnumber(r_.get(), name);
+    if (col < 0) throw std::runtime_error(std::string("No column ") + name + " in result");
+    return col;
+}
+
+int PgResult::asInt(int row, int col) const {
+    return std::stoi(PQgetvalue(r_.get(), row, col));
+}
+
+// ----------------- AsyncConnection -----------------
+
+// Ожидание готовности сокета libpq на io_context соединения
+struct AsyncConnection::SocketWait {
+    AsyncConnection &conn;
+    bool write;
+    asio::error_code ec{};
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) {
+        auto type = write ? asio::posix::stream_descriptor::wait_write : asio::posix::stream_descriptor::wait_read;
+        conn.socket_.async_wait(type, [this, h](const asio::error_code &e) {
+            ec = e;
+            h.resume();
+        });
+    }
+    void await_resume() const {
+        if (ec) throw std::runtime_error("PostgreSQL socket wait failed: " + ec.message());
+    }
+};
+
+AsyncConnection::~AsyncConnection() {
+    // Дескриптор принадлежит libpq: asio его не закрывает
+    if (socket_.is_open()) socket_.release();
+    if (conn_) PQfinish(conn_);
+}
+
+AsyncConnection::SocketWait AsyncConnection::wait(bool write) {
+    // Во время PQconnectPoll libpq может сменить сокет (например, при переборе адресов)
+    int fd = PQsocket(conn_);
+    if (fd < 0) throw std::runtime_error("PostgreSQL connection has no socket");
+    if (fd != fd_) {
+        if (socket_.is_open()) socket_.release();
+        socket_.assign(fd);
+        fd_ = fd;
+    }
+    return SocketWait{*this, write};
+}
+
+Task<void> AsyncConnection::connect(std::string conn_str, const std::vector<std::pair<std::string, std::string>> &statements) {
+    conn_ = PQconnectStart(conn_str.c_str());
+    if (!conn_) throw std::runtime_error("PQconnectStart: out of memory");
+    if (PQstatus(conn_) == CONNECTION_BAD) throw std::runtime_error(PQerrorMessage(conn_));
+
+    PostgresPollingStatusType status = PGRES_POLLING_WRITING;
+    while (status != PGRES_POLLING_OK) {
+        if (status == PGRES_POLLING_FAILED) throw std::runtime_error(PQerrorMessage(conn_));
+        co_await wait(status == PGRES_POLLING_WRITING);
+        status = PQconnectPoll(conn_);
+    }
+    if (PQsetnonblocking(conn_, 1) != 0) throw std::runtime_error(PQerrorMessage(conn_));
+    if (statements.empty()) co_return;
+
+    // Все Parse уходят одним конвейером. Sync после каждого: ошибка одного запроса
+    // не отменяет подготовку остальных
+    if (!PQenterPipelineMode(conn_)) throw std::runtime_error(PQerrorMessage(conn_));
+    for (auto &[name, sql] : statements) {
+        if (!PQsendPrepare(conn_, name.c_str(), sql.c_str(), 0, nullptr) || !PQpipelineSync(conn_))
+            throw std::runtime_error(PQerrorMessage(conn_));
+    }
+    co_await flush();
+
+    for (auto &[name, sql] : statements) {
+        while (PGresult *r = co_await nextResult()) {
+            if (PQresultStatus(r) == PGRES_FATAL_ERROR)
+                std::cerr << "Error preparing " << name << ": " << PQresultErrorMessage(r) << std::endl;
+            PQclear(r);
+        }
+        PgResult sync(co_await nextResult());
+        if (!sync || PQresultStatus(sync.get()) != PGRES_PIPELINE_SYNC)
+            throw std::runtime_error("Pipeline out of sync");
+    }
+    if (!PQexitPipelineMode(conn_)) throw std::runtime_error(PQerrorMessage(conn_));
+}
+
+// В QueryStats; result == nullptr — запрос завершился ошибкой. Параметры здесь уже текст,
+// в журнал медленных запросов попадает только их длина
+void AsyncConnection::recordStatement(const std::string &name, std::chrono::microseconds elapsed, const PgResult *result,
+                                      std::chrono::microseconds wait, const std::vector<std::string> &params) {
+    auto &stats = QueryStats::instance();
+    uint64_t rows = result && *result ? result->rows() : 0;
+    stats.record(name, elapsed, rows, wait, !result);
+    if (!stats.isSlow(elapsed)) return;
+    std::vector<std::string> redacted;
+    for (auto &p : params) redacted.push_back(redactParam(p));
+    stats.logSlow(name, elapsed, rows, wait, redacted);
+}
+
+Task<PgResult> AsyncConnection::execPrepared(std::string name, std::vector<std::string> params) {
+    std::vector<const char *> values;
+    values.reserve(params.size());
+    for (auto &p : params) values.push_back(p.c_str());
+
+    auto start = std::chrono::steady_clock::now();
+    auto wait = std::exchange(wait_, std::chrono::microseconds(0));
+    if (!PQsendQueryPrepared(conn_, name.c_str(), static_cast<int>(values.size()), values.data(), nullptr, nullptr, 0))
+        throw std::runtime_error(name + ": " + PQerrorMessage(conn_));
+
+    PgResult result;
+    std::exception_ptr error;
+    try {
+        result = co_await finish();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    recordStatement(name, elapsed, error ? nullptr : &result, wait, params);
+    if (error) std::rethrow_exception(error);
+    co_return result;
+}
+
+Task<PgResult> AsyncConnection::exec(std::string sql) {
+    if (!PQsendQuery(conn_, sql.c_str())) throw std::runtime_error(PQerrorMessage(conn_));
+    co_return co_await finish();
+}
+
+// Неблокирующий режим: запрос мог уйти в сокет не целиком
+Task<void> AsyncConnection::flush() {
+    for (int pending; (pending = PQflush(conn_)) != 0;) {
+        if (pending < 0) throw std::runtime_error(PQerrorMessage(conn_));
+        co_await wait(true);
+    }
+}
+
+Task<PGresult *> AsyncConnection::nextResult() {
+    while (PQisBusy(conn_)) {
+        co_await wait(false);
+        if (!PQconsumeInput(conn_)) throw std::runtime_error(PQerrorMessage(conn_));
+    }
+    co_return PQgetResult(conn_);
+}
+
+static bool succeeded(const PgResult &r) {
+    ExecStatusType st = PQresultStatus(r.get());
+    return st == PGRES_TUPLES_OK || st == PGRES_COMMAND_OK;
+}
+
+// Результатов одного запроса может быть несколько: оставляем первый, но ошибку предпочитаем
+Task<PgResult> AsyncConnection::finish() {
+    co_await flush();
+
+    PgResult result;
+    while (PGresult *r = co_await nextResult()) {
+        if (!result || (succeeded(result) && PQresultStatus(r) == PGRES_FATAL_ERROR)) result = PgResult(r);
+        else PQclear(r);
+    }
+
+    if (!result) throw std::runtime_error("PostgreSQL returned no result");
+    if (!succeeded(result)) throw std::runtime_error(PQresultErrorMessage(result.get()));
+    co_return result;
+}
+
+Task<std::vector<PgResult>> AsyncConnection::pipeline(std::vector<PipelineStatement> statements) {
+    auto start = std::chrono::steady_clock::now();
+    if (!PQenterPipelineMode(conn_)) throw std::runtime_error(PQerrorMessage(conn_));
+
+    for (auto &st : statements) {
+        int ok;
+        if (st.sql) {
+            ok = PQsendQueryParams(conn_, st.name.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 0);
+        } else {
+            std::vector<const char *> values;
+            values.reserve(st.params.size());
+            for (auto &p : st.params) values.push_back(p.c_str());
+            ok = PQsendQueryPrepared(conn_, st.name.c_str(), static_cast<int>(values.size()), values.data(), nullptr, nullptr, 0);
+        }
+        if (!ok) throw std::runtime_error(st.name + ": " + PQerrorMessage(conn_));
+    }
+    if (!PQpipelineSync(conn_)) throw std::runtime_error(PQerrorMessage(conn_));
+    co_await flush();
+
+    // На каждый запрос: его результаты и nullptr; после ошибки — PGRES_PIPELINE_ABORTED
+    std::vector<PgResult> results;
+    results.reserve(statements.size());
+    std::string error;
+    for (auto &st : statements) {
+        PgResult result;
+        while (PGresult *r = co_await nextResult()) {
+            if (!result) result = PgResult(r);
+            else PQclear(r);
+        }
+        bool failed = result && PQresultStatus(result.get()) == PGRES_FATAL_ERROR;
+        if (failed && error.empty()) error = st.name + ": " + PQresultErrorMessage(result.get());
+        // Время запроса конвейера — от отправки конвейера до его результата; пропущенные после ошибки не считаются
+        if (!st.sql && !(result && PQresultStatus(result.get()) == PGRES_PIPELINE_ABORTED)) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+            recordStatement(st.name, elapsed, failed ? nullptr : &result, std::exchange(wait_, std::chrono::microseconds(0)), st.params);
+        }
+        results.push_back(std::move(result));
+    }
+
+    PgResult sync(co_await nextResult());
+    if (!sync || PQresultStatus(sync.get()) != PGRES_PIPELINE_SYNC)
+        throw std::runtime_error("Pipeline out of sync");
+    if (!PQexitPipelineMode(conn_)) throw std::runtime_error(PQerrorMessage(conn_));
+
+    if (!error.empty()) throw std::runtime_error(error);
+    co_return results;
+}
+
+Task<std::vector<PgResult>> AsyncConnection::transaction(std::vector<PipelineStatement> statements, std::string begin) {
+    statements.insert(statements.begin(), PipelineStatement::text(std::move(begin)));
+    statements.push_back(PipelineStatement::text("COMMIT"));
+
+    std::exception_ptr error;
+    std::vector<PgResult> results;
+    try {
+        results = co_await pipeline(std::move(statements));
+    } catch (...) {
+        error = std::current_exception();
+    }
+    if (error) {
+        // COMMIT был пропущен вместе с остальными запросами — транзакция осталась открытой
+        if (conn_ && PQtransactionStatus(conn_) != PQTRANS_IDLE && PQpipelineStatus(conn_) == PQ_PIPELINE_OFF) {
+            try {
+                co_await exec("ROLLBACK");
+            } catch (const std::exception &) {
+            }
+        }
+        std::rethrow_exception(error);
+    }
+
+    results.erase(results.begin());
+    results.pop_back();
+    co_return results;
+}
+
+bool AsyncConnection::reusable() const {
+    return conn_ && PQstatus(conn_) == CONNECTION_OK && PQtransactionStatus(conn_) == PQTRANS_IDLE &&
+           PQpipelineStatus(conn_) == PQ_PIPELINE_OFF;
+}
+
+// ----------------- AsyncDatabase -----------------
+
+AsyncDatabase::AsyncDatabase(std::string conn_str, std::vector<std::pair<std::string, std::string>> statements, size_t per_context)
+    : conn_str_(std::move(conn_str)), statements_(std::move(statements)), per_context_(per_context == 0 ? 1 : per_context) {}
+
+AsyncDatabase::Lease::~Lease() {
+    if (db_ && ctx_ && conn_) db_->release(*ctx_, std::move(conn_));
+}
+
+AsyncDatabase::Context &AsyncDatabase::contextFor(asio::io_context &io) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto &ctx = contexts_[&io];
+    if (!ctx) ctx = std::make_unique<Context>(io);
+    return *ctx;
+}
+
+// Встать в очередь пула, пока release() не передаст соединение или слот
+struct AsyncDatabase::SlotWait {
+    Context &ctx;
+    Waiter &waiter;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) {
+        waiter.handle = h;
+        ctx.waiters.push_back(&waiter);
+    }
+    void await_resume() const noexcept {}
+};
+
+Task<AsyncDatabase::Lease> AsyncDatabase::acquire(asio::io_context &io) {
+    Context &ctx = contextFor(io);
+
+    std::unique_ptr<AsyncConnection> conn;
+    std::chrono::microseconds waited{0};
+    if (!ctx.idle.empty()) {
+        conn = std::move(ctx.idle.back());
+        ctx.idle.pop_back();
+    } else if (ctx.open < per_context_) {
+        ++ctx.open; // слот занят, соединение откроем ниже
+    } else {
+        Waiter waiter;
+        auto start = std::chrono::steady_clock::now();
+        ++waiting_;
+        co_await SlotWait{ctx, waiter};
+        --waiting_;
+        ++waits_;
+        waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        wait_us_ += waited.count();
+        conn = std::move(waiter.conn);
+    }
+
+    if (!conn) {
+        auto fresh = std::make_unique<AsyncConnection>(io);
+        std::exception_ptr error;
+        try {
+            co_await fresh->connect(conn_str_, statements_);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        if (error) {
+            release(ctx, nullptr); // вернуть слот
+            std::rethrow_exception(error);
+        }
+        conn = std::move(fresh);
+    }
+    conn->chargeWait(waited);
+    co_return Lease(this, &ctx, std::move(conn));
+}
+
+ConnectionPool::Stats AsyncDatabase::stats() const {
+    return {waits_.load(), wait_us_.load(), waiting_.load()};
+}
+
+// Соединение после ошибки (оборванное или внутри транзакции) закрывается; ожидающий получает
+// пустой слот и откроет новое
+void AsyncDatabase::release(Context &ctx, std::unique_ptr<AsyncConnection> conn) {
+    if (conn && !conn->reusable()) conn.reset();
+
+    if (!ctx.waiters.empty()) {
+        Waiter *w = ctx.waiters.front();
+        ctx.waiters.pop_front();
+        w->conn = std::move(conn);
+        // Продолжить ожидающего отдельным шагом, а не внутри деструктора Lease
+        asio::post(ctx.io, [h = w->handle]() { h.resume(); });
+        return;
+    }
+    if (conn) ctx.idle.push_back(std::move(conn));
+    else --ctx.open;
+}
+
+// Журнал: занятия, студенты и оценки в одном снимке, как в GET /teacher/journal.
+// Три запроса и BEGIN/COMMIT уходят одним конвейером
+Task<void> AsyncDatabase::writeJournal(asio::io_context &io, int course_id, int group_id, JsonWriter &out,
+                                       std::vector<PendingGrade> pending) {
+    auto conn = co_await acquire(io);
+    std::vector<PipelineStatement> statements;
+    statements.push_back(PipelineStatement::prepared(q::get_journal_lessons, course_id, group_id));
+    statements.push_back(PipelineStatement::prepared(q::get_students_by_group_, group_id));
+    statements.push_back(PipelineStatement::prepared(q::get_journal_grades, course_id, group_id));
+    auto r = co_await conn->transaction(std::move(statements), "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY");
+    PgResult lessons = std::move(r[0]), students = std::move(r[1]), grades = std::move(r[2]);
+
+    out.beginObject();
+
+    out.key("lessons").beginArray();
+    int l_id = lessons.column("id"), l_date = lessons.column("lesson_date"), l_hw = lessons.column("homework");
+    for (int i = 0; i < lessons.rows(); ++i) {
+        out.beginObject();
+        out.key("id").raw(lessons.value(i, l_id));
+        out.key("lesson_date").string(lessons.value(i, l_date));
+        if (lessons.isNull(i, l_hw)) out.key("homework").null();
+        else out.key("homework").string(lessons.value(i, l_hw));
+        out.endObject();
+    }
+    out.endArray();
+
+    out.key("students").beginArray();
+    int s_id = students.column("id"), s_first = students.column("first_name"), s_last = students.column("last_name");
+    for (int i = 0; i < students.rows(); ++i) {
+        out.beginObject();
+        out.key("id").raw(students.value(i, s_id));
+        out.key("first_name").string(students.value(i, s_first));
+        out.key("last_name").string(students.value(i, s_last));
+        out.endObject();
+    }
+    out.endArray();
+
+    // Ожидающие записи оценки этого журнала: ячейка (студент, занятие) -> оценка
+    std::unordered_map<uint64_t, const PendingGrade *> overlay;
+    if (!pending.empty()) {
+        std::unordered_set<int> lesson_ids, student_ids;
+        for (int i = 0; i < lessons.rows(); ++i) lesson_ids.insert(lessons.asInt(i, l_id));
+        for (int i = 0; i < students.rows(); ++i) student_ids.insert(students.asInt(i, s_id));
+        for (auto &p : pending) {
+            if (lesson_ids.count(p.lesson_id) && student_ids.count(p.student_id))
+                overlay[(static_cast<uint64_t>(p.student_id) << 32) | static_cast<uint32_t>(p.lesson_id)] = &p;
+        }
+    }
+    auto writeGrade = [&out](std::string_view student_id, std::string_view lesson_id, std::string_view grade) {
+        out.beginObject();
+        out.key("student_id").raw(student_id);
+        out.key("lesson_id").raw(lesson_id);
+        out.key("grade").string(grade);
+        out.endObject();
+    };
+
+    out.key("grades").beginArray();
+    int g_sid = grades.column("student_id"), g_lid = grades.column("lesson_id"), g_grade = grades.column("grade");
+    for (int i = 0; i < grades.rows(); ++i) {
+        if (!overlay.empty()) {
+            auto it = overlay.find((static_cast<uint64_t>(grades.asInt(i, g_sid)) << 32) |
+                                   static_cast<uint32_t>(grades.asInt(i, g_lid)));
+            if (it != overlay.end()) continue; // будет записана ниже из очереди
+        }
+        writeGrade(grades.value(i, g_sid), grades.value(i, g_lid), grades.value(i, g_grade));
+    }
+    for (auto &[key, p] : overlay) {
+        writeGrade(std::to_string(p->student_id), std::to_string(p->lesson_id), gradeText(p->score, p->absent));
+    }
+    out.endArray();
+
+    out.endObject();
+}
+
+Task<void> AsyncDatabase::writeStudentGrades(asio::io_context &io, int student_id, JsonWriter &out) {
+    auto conn = co_await acquire(io);
+    auto r = co_await conn.query(q::get_student_grades, student_id);
+
+    int c_id = r.column("course_id"), c_name = r.column("course_name"), grade = r.column("grade"), date = r.column("date_assigned");
+    out.beginArray();
+    for (int i = 0; i < r.rows(); ++i) {
+        out.beginObject();
+        out.key("course_id").raw(r.value(i, c_id));
+        out.key("course_name").string(r.value(i, c_name));
+        out.key("grade").string(r.value(i, grade));
+        out.key("date_assigned").string(r.value(i, date));
+        out.endObject();
+    }
+    out.endArray();
+}
+
+Task<std::vector<StudentRating>> AsyncDatabase::getGroupRating(asio::io_context &io, int student_id) {
+    auto conn = co_await acquire(io);
+    auto r = co_await conn.query(q::get_group_rating, student_id);
+
+    int id = r.column("id"), first = r.column("first_name"), last = r.column("last_name");
+    int sum = r.column("score_sum"), count = r.column("score_count");
+    std::vector<StudentRating> rating;
+    rating.reserve(r.rows());
+    for (int i = 0; i < r.rows(); ++i) {
+        int n = r.isNull(i, count) ? 0 : r.asInt(i, count);
+        double avg = n ? static_cast<double>(r.asInt(i, sum)) / n : 0.0;
+        rating.push_back({r.asInt(i, id), std::string(r.value(i, first)), std::string(r.value(i, last)), avg});
+    }
+    sortGroupRating(rating);
+    co_return rating;
+}
+
+// Профиль ищет пользователя по логину внутри той же транзакции, поэтому оба INSERT
+// не ждут друг друга и идут одним конвейером
+Task<void> AsyncDatabase::addStudent(asio::io_context &io, Student s, std::string login, std::string password_hash) {
+    auto conn = co_await acquire(io);
+    std::vector<PipelineStatement> statements;
+    statements.push_back(PipelineStatement::prepared(q::insert_user, login, password_hash, std::string("STUDENT"), s.first_name, s.last_name));
+    statements.push_back(PipelineStatement::prepared(q::insert_student_for_login, login, s.dob, s.group_id));
+    co_await conn->transaction(std::move(statements));
+}
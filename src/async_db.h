@@ -0,0 +1,187 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <libpq-fe.h>
+#include <crow.h>
+#include "db.h"
+#include "json_writer.h"
+#include "query_catalog.h"
+#include "task.h"
+
+// Асинхронный доступ к PostgreSQL поверх неблокирующего API libpq.
+// Запрос отправляется PQsendQueryPrepared, а готовность сокета ждётся на том же
+// asio::io_context, который обслуживает HTTP-соединение. Пока ответа нет, поток Crow
+// обрабатывает другие запросы, так что несколько потоков держат в работе сотни запросов.
+//
+// Всё, что относится к одному io_context (его соединения и очередь ожидающих), используется
+// только из его потока; общий мьютекс защищает лишь таблицу io_context -> пул.
+
+// Результат libpq во владении
+class PgResult {
+public:
+    PgResult() = default;
+    explicit PgResult(PGresult *r) : r_(r, &PQclear) {}
+
+    explicit operator bool() const { return r_ != nullptr; }
+    PGresult *get() const { return r_.get(); }
+
+    int rows() const { return PQntuples(r_.get()); }
+    int column(const char *name) const;  // runtime_error, если столбца нет
+    bool isNull(int row, int col) const { return PQgetisnull(r_.get(), row, col); }
+    std::string_view value(int row, int col) const {
+        return {PQgetvalue(r_.get(), row, col), static_cast<size_t>(PQgetlength(r_.get(), row, col))};
+    }
+    int asInt(int row, int col) const;
+
+private:
+    std::unique_ptr<PGresult, decltype(&PQclear)> r_{nullptr, &PQclear};
+};
+
+inline std::string toParam(int v) { return std::to_string(v); }
+inline std::string toParam(bool v) { return v ? "t" : "f"; }
+inline std::string toParam(std::string v) { return v; }
+
+// Запрос для конвейера: подготовленный по имени или текст SQL без параметров
+struct PipelineStatement {
+    std::string name; // имя подготовленного запроса или SQL
+    std::vector<std::string> params;
+    bool sql = false;
+
+    static PipelineStatement text(std::string sql) { return {std::move(sql), {}, true}; }
+    template <int N, typename... Args>
+    static PipelineStatement prepared(const Query<N> &query, Args... args) {
+        static_assert(sizeof...(Args) == N, "wrong number of query parameters");
+        return {query.name, {toParam(std::move(args))...}, false};
+    }
+};
+
+// Одно неблокирующее соединение; живёт в потоке своего io_context
+class AsyncConnection {
+public:
+    explicit AsyncConnection(asio::io_context &io) : socket_(io) {}
+    ~AsyncConnection();
+
+    AsyncConnection(const AsyncConnection &) = delete;
+    AsyncConnection &operator=(const AsyncConnection &) = delete;
+
+    // PQconnectStart/PQconnectPoll + подготовка запросов одним конвейером;
+    // ошибки подготовки только логируются
+    Task<void> connect(std::string conn_str, const std::vector<std::pair<std::string, std::string>> &statements);
+
+    Task<PgResult> execPrepared(std::string name, std::vector<std::string> params);
+    Task<PgResult> exec(std::string sql);
+
+    // Конвейер libpq (pipeline mode): все запросы уходят подряд, затем Sync, и результаты
+    // читаются вместе — один сетевой круг вместо N. Ошибка любого запроса — исключение
+    // (после него сервер пропускает остальные до Sync).
+    Task<std::vector<PgResult>> pipeline(std::vector<PipelineStatement> statements);
+    // BEGIN, statements..., COMMIT одним конвейером; результаты только для statements.
+    // При ошибке транзакция откатывается.
+    Task<std::vector<PgResult>> transaction(std::vector<PipelineStatement> statements, std::string begin = "BEGIN");
+
+    // Можно вернуть в пул: соединение живо и вне транзакции
+    bool reusable() const;
+
+    // Ожидание в пуле перед выдачей соединения: в QueryStats достаётся первому запросу
+    void chargeWait(std::chrono::microseconds wait) { wait_ = wait; }
+
+private:
+    struct SocketWait;
+    SocketWait wait(bool write);
+    Task<void> flush();
+    Task<PGresult *> nextResult(); // следующий PGresult или nullptr (конец результатов запроса)
+    Task<PgResult> finish(); // отправить буфер и собрать результат
+    void recordStatement(const std::string &name, std::chrono::microseconds elapsed, const PgResult *result,
+                         std::chrono::microseconds wait, const std::vector<std::string> &params);
+
+    PGconn *conn_ = nullptr;
+    asio::posix::stream_descriptor socket_;
+    int fd_ = -1;
+    std::chrono::microseconds wait_{0};
+};
+
+class AsyncDatabase {
+public:
+    // per_context — сколько соединений может открыть каждый поток Crow
+    AsyncDatabase(std::string conn_str, std::vector<std::pair<std::string, std::string>> statements, size_t per_context);
+
+    AsyncDatabase(const AsyncDatabase &) = delete;
+    AsyncDatabase &operator=(const AsyncDatabase &) = delete;
+
+    // Ожидающий свободного соединения; release() передаёт ему соединение (или пустой слот)
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        std::unique_ptr<AsyncConnection> conn;
+    };
+
+    // Пул одного io_context
+    struct Context {
+        explicit Context(asio::io_context &io) : io(io) {}
+        asio::io_context &io;
+        std::vector<std::unique_ptr<AsyncConnection>> idle;
+        size_t open = 0; // открыто или открывается, включая выданные
+        std::deque<Waiter *> waiters;
+    };
+
+    // Соединение, занятое корутиной; при разрушении возвращается в пул своего io_context
+    class Lease {
+    public:
+        Lease(AsyncDatabase *db, Context *ctx, std::unique_ptr<AsyncConnection> conn)
+            : db_(db), ctx_(ctx), conn_(std::move(conn)) {}
+        Lease(Lease &&other) noexcept = default;
+        Lease &operator=(Lease &&) = delete;
+        ~Lease();
+
+        AsyncConnection *operator->() { return conn_.get(); }
+
+        template <int N, typename... Args>
+        Task<PgResult> query(const Query<N> &q, Args... args) {
+            static_assert(sizeof...(Args) == N, "wrong number of query parameters");
+            return conn_->execPrepared(q.name, {toParam(std::move(args))...});
+        }
+
+    private:
+        AsyncDatabase *db_;
+        Context *ctx_;
+        std::unique_ptr<AsyncConnection> conn_;
+    };
+
+    // Взять соединение пула этого io_context (ждёт, если все заняты)
+    Task<Lease> acquire(asio::io_context &io);
+
+    // Ожидание соединения во всех io_context (для /metrics), как ConnectionPool::Stats
+    ConnectionPool::Stats stats() const;
+
+    // Асинхронные варианты методов Database
+    // pending — оценки из GradeQueue поверх прочитанных из БД (read-your-writes)
+    Task<void> writeJournal(asio::io_context &io, int course_id, int group_id, JsonWriter &out,
+                            std::vector<PendingGrade> pending = {});
+    Task<void> writeStudentGrades(asio::io_context &io, int student_id, JsonWriter &out);
+    Task<std::vector<StudentRating>> getGroupRating(asio::io_context &io, int student_id);
+    // Пользователь и профиль студента одной транзакцией в одном конвейере
+    Task<void> addStudent(asio::io_context &io, Student s, std::string login, std::string password_hash);
+
+private:
+    struct SlotWait;
+
+    Context &contextFor(asio::io_context &io);
+    void release(Context &ctx, std::unique_ptr<AsyncConnection> conn);
+
+    std::string conn_str_;
+    std::vector<std::pair<std::string, std::string>> statements_;
+    size_t per_context_;
+
+    std::mutex mtx_;
+    std::unordered_map<asio::io_context *, std::unique_ptr<Context>> contexts_;
+
+    std::atomic<uint64_t> waits_{0}, wait_us_{0};
+    std::atomic<int64_t> waiting_{0};
+};
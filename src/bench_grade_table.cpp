@@ -0,0 +1,123 @@
+// Бенчмарк таблицы оценок: старый цикл N×M запросов против одного запроса get_grade_table.
+// Запросы и миграции встроены при сборке, каталог запуска любой:
+//   ./bench_grade_table ["dbname=students_db user=admin password=admin host=localhost"]
+// Создаёт временную группу/курс/студентов/занятия, замеряет и удаляет их за собой.
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <unistd.h>
+#include "db.h"
+#include "queries.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Fixture {
+    int group_id = 0;
+    int course_id = 0;
+    std::string prefix;
+};
+
+static Fixture seed(Database &db, int students, int lessons) {
+    Fixture f;
+    f.prefix = "bench_" + std::to_string(getpid()) + "_" + std::to_string(students) + "x" + std::to_string(lessons);
+
+    auto conn = db.acquire();
+    pqxx::work txn(*conn);
+    f.group_id = txn.exec("INSERT INTO groups (name) VALUES (" + txn.quote(f.prefix) + ") RETURNING id")[0][0].as<int>();
+    f.course_id = txn.exec("INSERT INTO courses (name) VALUES (" + txn.quote(f.prefix) + ") RETURNING id")[0][0].as<int>();
+    std::string gid = std::to_string(f.group_id), cid = std::to_string(f.course_id);
+
+    txn.exec("INSERT INTO users (login, password_hash, role, first_name, last_name) "
+             "SELECT " + txn.quote(f.prefix + "_") + " || i, 'x', 'STUDENT', 'Имя' || i, 'Фамилия' || i "
+             "FROM generate_series(1, " + std::to_string(students) + ") i");
+    txn.exec("INSERT INTO students (user_id, group_id) SELECT id, " + gid + " FROM users "
+             "WHERE login LIKE " + txn.quote(f.prefix + "\\_%"));
+    txn.exec("INSERT INTO lessons (course_id, group_id, lesson_date) "
+             "SELECT " + cid + ", " + gid + ", DATE '2025-09-01' + i "
+             "FROM generate_series(0, " + std::to_string(lessons - 1) + ") i");
+    // Заполняем ~70% ячеек, из них ~10% — пропуски "Н"
+    txn.exec("INSERT INTO grades (student_id, lesson_id, score, absent) "
+             "SELECT id, lesson_id, CASE WHEN absent THEN NULL ELSE (1 + floor(random() * 5))::smallint END, absent "
+             "FROM (SELECT s.id, l.id AS lesson_id, random() < 0.1 AS absent "
+             "FROM students s JOIN lessons l ON l.group_id = s.group_id AND l.course_id = " + cid + " "
+             "WHERE s.group_id = " + gid + " AND random() < 0.7) cells");
+    txn.exec("ANALYZE grades");
+    txn.commit();
+    return f;
+}
+
+static void cleanup(Database &db, const Fixture &f) {
+    auto conn = db.acquire();
+    pqxx::work txn(*conn);
+    txn.exec("DELETE FROM users WHERE login LIKE " + txn.quote(f.prefix + "\\_%"));
+    txn.exec("DELETE FROM courses WHERE id = " + std::to_string(f.course_id));
+    txn.exec("DELETE FROM groups WHERE id = " + std::to_string(f.group_id));
+    txn.commit();
+}
+
+// Старая реализация getGradeTable: по запросу на каждую пару (студент, занятие)
+static size_t gradeTableLoop(Database &db, int course_id, int group_id, size_t &round_trips) {
+    auto conn = db.acquire();
+    pqxx::work txn(*conn);
+    auto students_r = execQuery(txn, q::get_students_by_group, group_id);
+    auto lessons_r = execQuery(txn, q::get_lessons, course_id, group_id);
+    round_trips += 2;
+    size_t cells = 0;
+    for (auto const& s : students_r) {
+        for (auto const& l : lessons_r) {
+            execQuery(txn, q::get_grade_by_student_lesson, s["id"].as<int>(), l["id"].as<int>());
+            ++round_trips;
+            ++cells;
+        }
+    }
+    txn.commit();
+    return cells;
+}
+
+template <typename F>
+static double timeMs(F &&fn, int reps) {
+    auto start = Clock::now();
+    for (int i = 0; i < reps; ++i) fn();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / reps;
+}
+
+int main(int argc, char **argv) {
+    std::string conn_str = argc > 1 ? argv[1] : "dbname=students_db user=admin password=admin host=localhost";
+
+    try {
+        Database db(conn_str, 2);
+
+        const int sizes[][2] = {{30, 80}, {200, 200}};
+        std::cout << std::left << std::setw(10) << "grid"
+                  << std::setw(12) << "variant" << std::setw(14) << "round_trips"
+                  << std::setw(12) << "cells" << "latency_ms" << std::endl;
+
+        for (auto &sz : sizes) {
+            int students = sz[0], lessons = sz[1];
+            Fixture f = seed(db, students, lessons);
+            std::string grid = std::to_string(students) + "x" + std::to_string(lessons);
+            int reps = students * lessons > 10000 ? 3 : 10;
+
+            try {
+                size_t rt = 0, cells = 0;
+                double before = timeMs([&] { rt = 0; cells = gradeTableLoop(db, f.course_id, f.group_id, rt); }, reps);
+                std::cout << std::setw(10) << grid << std::setw(12) << "loop" << std::setw(14) << rt
+                          << std::setw(12) << cells << std::fixed << std::setprecision(2) << before << std::endl;
+
+                size_t after_cells = 0;
+                double after = timeMs([&] { after_cells = db.getGradeTable(f.course_id, f.group_id).size(); }, reps);
+                std::cout << std::setw(10) << grid << std::setw(12) << "set-based" << std::setw(14) << 1
+                          << std::setw(12) << after_cells << std::fixed << std::setprecision(2) << after << std::endl;
+            } catch (...) {
+                cleanup(db, f);
+                throw;
+            }
+            cleanup(db, f);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
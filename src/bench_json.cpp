@@ -0,0 +1,116 @@
+// Сравнение сериализации списка студентов: vector<Student> -> wvalue -> dump()
+// против JsonWriter прямо из текстовых полей (как их отдаёт libpq).
+//   ./bench_json [число_строк] [повторов]
+// Считает выделения памяти (глобальный operator new) и время на один ответ.
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "json_writer.h"
+#include "db.h"
+
+using Clock = std::chrono::steady_clock;
+
+static size_t g_allocs = 0;
+
+void *operator new(size_t n) {
+    ++g_allocs;
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+// Строка результата в текстовом виде: id, first_name, last_name, login, dob, group_id
+using TextRow = std::vector<std::string>;
+
+static std::vector<TextRow> makeRows(size_t n) {
+    std::vector<TextRow> rows;
+    for (size_t i = 0; i < n; ++i) {
+        rows.push_back({std::to_string(i + 1), "Иван" + std::to_string(i), "Петров \"мл.\"",
+                        "student" + std::to_string(i), "2004-05-17", std::to_string(i % 40 + 1)});
+    }
+    return rows;
+}
+
+// Как было: строки -> структуры -> дерево wvalue -> текст
+static std::string viaWvalue(const std::vector<TextRow> &rows) {
+    std::vector<Student> students;
+    for (auto &r : rows) {
+        Student s;
+        s.id = std::stoi(r[0]);
+        s.first_name = r[1];
+        s.last_name = r[2];
+        s.login = r[3];
+        s.dob = r[4];
+        s.group_id = std::stoi(r[5]);
+        students.push_back(s);
+    }
+    crow::json::wvalue res = crow::json::wvalue::list();
+    for (size_t i = 0; i < students.size(); ++i) {
+        res[i]["id"] = students[i].id;
+        res[i]["first_name"] = students[i].first_name;
+        res[i]["last_name"] = students[i].last_name;
+        res[i]["login"] = students[i].login;
+        res[i]["dob"] = students[i].dob;
+        res[i]["group_id"] = students[i].group_id;
+    }
+    return res.dump();
+}
+
+// Как стало: поля сразу в буфер ответа
+static std::string viaWriter(const std::vector<TextRow> &rows) {
+    JsonWriter out(64 * 1024);
+    out.beginArray();
+    for (auto &r : rows) {
+        out.beginObject();
+        out.key("id").raw(r[0]);
+        out.key("first_name").string(r[1]);
+        out.key("last_name").string(r[2]);
+        out.key("login").string(r[3]);
+        out.key("dob").string(r[4]);
+        out.key("group_id").raw(r[5]);
+        out.endObject();
+    }
+    out.endArray();
+    return out.take();
+}
+
+template <typename F>
+static void run(const char *name, F f, const std::vector<TextRow> &rows, int repeats) {
+    size_t bytes = f(rows).size(); // прогрев
+    size_t allocs_before = g_allocs;
+    auto start = Clock::now();
+    for (int i = 0; i < repeats; ++i) bytes = f(rows).size();
+    double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / repeats;
+    double allocs = double(g_allocs - allocs_before) / repeats;
+
+    std::cout << std::left << std::setw(8) << name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(1) << us << " us/resp"
+              << std::setw(12) << std::setprecision(0) << allocs << " allocs/resp"
+              << std::setw(10) << bytes << " bytes" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    size_t n = std::max<size_t>(1, argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000);
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 200;
+    auto rows = makeRows(n);
+
+    // Оба пути должны давать один и тот же документ
+    auto parsedA = crow::json::load(viaWvalue(rows));
+    auto parsedB = crow::json::load(viaWriter(rows));
+    if (!parsedA || !parsedB || parsedA.size() != parsedB.size() ||
+        parsedB[n - 1]["last_name"].s() != rows[n - 1][2] || parsedB[n - 1]["group_id"].i() != std::stoi(rows[n - 1][5])) {
+        std::cerr << "MISMATCH between wvalue and JsonWriter output" << std::endl;
+        return 1;
+    }
+
+    std::cout << "rows=" << n << " repeats=" << repeats << std::endl;
+    run("wvalue", viaWvalue, rows, repeats);
+    run("writer", viaWriter, rows, repeats);
+    return 0;
+}
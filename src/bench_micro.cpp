@@ -0,0 +1,277 @@
+// Микробенчмарки горячих функций сервера (БД не нужна). Результат — JSON в stdout,
+// чтобы сравнивать прогоны разных коммитов на одной машине:
+//   ./bench_micro [--filter <подстрока>] [--min-time <мс на замер>] [--web <каталог web>] [--queries <queries.sql>]
+// Каждый бенчмарк калибруется до --min-time на замер, затем делается SAMPLES замеров;
+// в JSON — нс на операцию (min/median/max по замерам) и число итераций в замере.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <crow.h>
+#include "auth.h"
+#include "crypto.h"
+#include "db.h"
+#include "json_writer.h"
+#include "query_parser.h"
+#include "static_cache.h"
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr int SAMPLES = 7;
+
+// Не дать компилятору выбросить результат
+template <typename T>
+static void keep(T &&value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Result {
+    std::string name;
+    uint64_t iterations; // в одном замере
+    double min_ns, median_ns, max_ns;
+};
+
+struct Options {
+    std::string filter;
+    double min_time_s = 0.2;
+    std::string web = "../web";
+    std::string queries = "queries.sql";
+};
+
+class Runner {
+public:
+    explicit Runner(const Options &options) : options_(options) {}
+
+    template <typename F>
+    void run(const std::string &name, F f) {
+        if (!options_.filter.empty() && name.find(options_.filter) == std::string::npos) return;
+
+        // Калибровка: удваиваем число итераций, пока замер короче min_time
+        uint64_t n = 1;
+        for (;;) {
+            double s = sample(f, n);
+            if (s >= options_.min_time_s || n >= (1ull << 40)) break;
+            n = s > 0 ? std::max(n * 2, static_cast<uint64_t>(n * options_.min_time_s / s * 1.2)) : n * 10;
+        }
+
+        std::vector<double> ns;
+        for (int i = 0; i < SAMPLES; ++i) ns.push_back(sample(f, n) * 1e9 / n);
+        std::sort(ns.begin(), ns.end());
+        results_.push_back({name, n, ns.front(), ns[ns.size() / 2], ns.back()});
+        std::cerr << name << ": " << ns[ns.size() / 2] << " ns/op" << std::endl;
+    }
+
+    const std::vector<Result> &results() const { return results_; }
+
+private:
+    template <typename F>
+    static double sample(F &f, uint64_t n) {
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < n; ++i) f();
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    const Options &options_;
+    std::vector<Result> results_;
+};
+
+// ----------------- Данные в форме ответов API -----------------
+
+static std::vector<User> makeUsers(size_t n) {
+    std::vector<User> users;
+    for (size_t i = 0; i < n; ++i) {
+        User u;
+        u.id = static_cast<int>(i + 1);
+        u.login = "user" + std::to_string(i);
+        u.role = i % 10 == 0 ? "TEACHER" : "STUDENT";
+        u.first_name = "Иван" + std::to_string(i);
+        u.last_name = "Петров";
+        users.push_back(u);
+    }
+    return users;
+}
+
+static std::vector<Student> makeStudents(size_t n) {
+    std::vector<Student> students;
+    for (size_t i = 0; i < n; ++i) {
+        Student s;
+        s.id = static_cast<int>(i + 1);
+        s.first_name = "Мария" + std::to_string(i);
+        s.last_name = "Сидорова \"мл.\"";
+        s.login = "student" + std::to_string(i);
+        s.dob = "2004-05-17";
+        s.group_id = static_cast<int>(i % 40 + 1);
+        students.push_back(s);
+    }
+    return students;
+}
+
+// GET /admin/users
+static crow::json::wvalue usersWvalue(const std::vector<User> &users) {
+    crow::json::wvalue res = crow::json::wvalue::list();
+    for (size_t i = 0; i < users.size(); ++i) {
+        res[i]["id"] = users[i].id;
+        res[i]["login"] = users[i].login;
+        res[i]["role"] = users[i].role;
+        res[i]["first_name"] = users[i].first_name;
+        res[i]["last_name"] = users[i].last_name;
+    }
+    return res;
+}
+
+// GET /admin/students
+static crow::json::wvalue studentsWvalue(const std::vector<Student> &students) {
+    crow::json::wvalue res = crow::json::wvalue::list();
+    for (size_t i = 0; i < students.size(); ++i) {
+        res[i]["id"] = students[i].id;
+        res[i]["first_name"] = students[i].first_name;
+        res[i]["last_name"] = students[i].last_name;
+        res[i]["login"] = students[i].login;
+        res[i]["dob"] = students[i].dob;
+        res[i]["group_id"] = students[i].group_id;
+    }
+    return res;
+}
+
+static std::string studentsWriter(const std::vector<Student> &students) {
+    JsonWriter out(64 * 1024);
+    out.beginArray();
+    for (auto &s : students) {
+        out.beginObject();
+        out.key("id").number(s.id);
+        out.key("first_name").string(s.first_name);
+        out.key("last_name").string(s.last_name);
+        out.key("login").string(s.login);
+        out.key("dob").string(s.dob);
+        out.key("group_id").number(s.group_id);
+        out.endObject();
+    }
+    out.endArray();
+    return out.take();
+}
+
+// GET /student/grades: по предмету — список оценок и средний балл
+static crow::json::wvalue gradesWvalue(size_t courses, size_t per_course) {
+    crow::json::wvalue res;
+    for (size_t i = 0; i < courses; ++i) {
+        std::vector<int> list;
+        for (size_t j = 0; j < per_course; ++j) list.push_back(static_cast<int>((i + j) % 4 + 2));
+        double sum = 0;
+        for (int g : list) sum += g;
+        res[i]["course"] = "Предмет " + std::to_string(i + 1);
+        res[i]["grades"] = crow::json::wvalue::list(list.begin(), list.end());
+        res[i]["average"] = sum / list.size();
+    }
+    return res;
+}
+
+// ----------------- Вывод -----------------
+
+static std::string hostName() {
+    char buf[256] = {};
+    if (gethostname(buf, sizeof(buf) - 1) != 0) return "";
+    return buf;
+}
+
+static std::string report(const std::vector<Result> &results) {
+    JsonWriter out;
+    out.beginObject();
+    const char *commit = std::getenv("BENCH_COMMIT");
+    out.key("commit").string(commit ? commit : "");
+    out.key("host").string(hostName());
+    out.key("compiler").string(__VERSION__);
+    out.key("cpus").number(std::thread::hardware_concurrency());
+    out.key("timestamp").number(static_cast<long long>(std::time(nullptr)));
+    out.key("samples").number(SAMPLES);
+    out.key("benchmarks").beginArray();
+    for (auto &r : results) {
+        out.beginObject();
+        out.key("name").string(r.name);
+        out.key("iterations").number(r.iterations);
+        out.key("ns_per_op").number(r.median_ns);
+        out.key("min_ns").number(r.min_ns);
+        out.key("max_ns").number(r.max_ns);
+        out.endObject();
+    }
+    out.endArray();
+    out.endObject();
+    return out.take();
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--filter") options.filter = argv[i + 1];
+        else if (arg == "--min-time") options.min_time_s = std::atof(argv[i + 1]) / 1000.0;
+        else if (arg == "--web") options.web = argv[i + 1];
+        else if (arg == "--queries") options.queries = argv[i + 1];
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    Runner bench(options);
+
+    // PBKDF2 (100 000 итераций) — самая дорогая операция /login
+    const std::string password = "correct horse battery staple";
+    const std::string hash = hashPassword(password);
+    bench.run("crypto/hashPassword", [&] { keep(hashPassword(password)); });
+    bench.run("crypto/checkPassword", [&] { keep(checkPassword(password, hash)); });
+    unsigned char digest[32];
+    for (int i = 0; i < 32; ++i) digest[i] = static_cast<unsigned char>(i * 37);
+    bench.run("crypto/bytesToHex_32", [&] { keep(bytesToHex(digest, sizeof(digest))); });
+
+    const std::string admin = "ADMIN", student = "student";
+    bench.run("auth/checkRole_match", [&] { keep(checkRole(admin, admin)); });
+    bench.run("auth/checkRole_mismatch", [&] { keep(checkRole(student, admin)); });
+
+    auto users = makeUsers(200);
+    auto students = makeStudents(500);
+    auto usersJson = usersWvalue(users);
+    auto studentsJson = studentsWvalue(students);
+    auto gradesJson = gradesWvalue(10, 20);
+    bench.run("json/users_200_wvalue_build", [&] { keep(usersWvalue(users)); });
+    bench.run("json/users_200_wvalue_dump", [&] { keep(usersJson.dump()); });
+    bench.run("json/students_500_wvalue_build", [&] { keep(studentsWvalue(students)); });
+    bench.run("json/students_500_wvalue_dump", [&] { keep(studentsJson.dump()); });
+    bench.run("json/students_500_writer", [&] { keep(studentsWriter(students)); });
+    bench.run("json/student_grades_10x20_wvalue_build", [&] { keep(gradesWvalue(10, 20)); });
+    bench.run("json/student_grades_10x20_wvalue_dump", [&] { keep(gradesJson.dump()); });
+
+    // Статика из памяти: как отдаётся index.html браузеру с разными заголовками
+    StaticCache assets(options.web);
+    crow::request plain, gzip, cached;
+    gzip.add_header("Accept-Encoding", "gzip");
+    cached.add_header("If-None-Match", assets.serve(plain, "index.html").get_header_value("ETag"));
+    bench.run("static/serve_identity", [&] { keep(assets.serve(plain, "index.html")); });
+    bench.run("static/serve_gzip", [&] { keep(assets.serve(gzip, "index.html")); });
+    bench.run("static/serve_not_modified", [&] { keep(assets.serve(cached, "index.html")); });
+
+    // Разбор queries.sql теперь идёт при сборке (gen_queries), при старте — только каталог q::all
+    std::ifstream sql(options.queries);
+    std::stringstream text;
+    text << sql.rdbuf();
+    const std::string queriesText = text.str();
+    if (queriesText.empty()) std::cerr << "[WARN] " << options.queries << " is empty or missing" << std::endl;
+    bench.run("queries/parse_sql", [&] {
+        std::istringstream in(queriesText);
+        auto statements = parseQueries(in);
+        for (auto &st : statements) st.arity = queryArity(st.sql);
+        keep(statements);
+    });
+    bench.run("queries/catalog", [&] { keep(queryStatements()); });
+
+    std::cout << report(bench.results()) << std::endl;
+    return 0;
+}
@@ -0,0 +1,96 @@
+// Микробенчмарк пакетного PBKDF2 против OpenSSL (один поток = одно ядро).
+//   ./bench_pbkdf2 [число_паролей]
+// Сначала сверяет результат пакетного пути с PKCS5_PBKDF2_HMAC побайтно.
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include "crypto.h"
+
+using Clock = std::chrono::steady_clock;
+
+static std::string opensslKey(const std::string &password, const std::string &salt, int iterations) {
+    std::string key(32, '\0');
+    PKCS5_PBKDF2_HMAC(password.c_str(), password.length(),
+                      reinterpret_cast<const unsigned char *>(salt.data()), salt.size(), iterations,
+                      EVP_sha256(), key.size(), reinterpret_cast<unsigned char *>(&key[0]));
+    return key;
+}
+
+static std::string randomBytes(size_t n) {
+    std::string s(n, '\0');
+    RAND_bytes(reinterpret_cast<unsigned char *>(&s[0]), n);
+    return s;
+}
+
+// Побайтная сверка на паролях разной длины (в т.ч. > 64 байт) и неполных пачках
+static bool verify() {
+    const size_t lengths[] = {0, 1, 5, 31, 55, 63, 64, 65, 100, 200};
+    std::vector<std::string> passwords, salts;
+    for (size_t i = 0; i < 37; ++i) {
+        passwords.push_back(randomBytes(lengths[i % 10]));
+        salts.push_back(randomBytes(16));
+    }
+    passwords.push_back("пароль");
+    salts.push_back(randomBytes(16));
+
+    const int iterations[] = {1, 2, 1000};
+    for (int it : iterations) {
+        for (size_t count : {size_t(1), size_t(7), size_t(17), passwords.size()}) {
+            std::vector<std::string> p(passwords.begin(), passwords.begin() + count);
+            std::vector<std::string> s(salts.begin(), salts.begin() + count);
+            std::vector<std::string> keys;
+            pbkdf2Sha256Batch(p, s, it, keys);
+            for (size_t i = 0; i < count; ++i) {
+                if (keys[i] != opensslKey(p[i], s[i], it)) {
+                    std::cerr << "MISMATCH: iterations=" << it << " batch=" << count << " index=" << i
+                              << " password_len=" << p[i].size() << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Формат salt:hash должен проверяться обычным checkPassword
+    auto hashes = hashPasswords({"admin", "secret"});
+    return checkPassword("admin", hashes[0]) && checkPassword("secret", hashes[1]) &&
+           !checkPassword("admin", hashes[1]);
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    const int iterations = 100000;
+
+    std::cout << "impl: " << pbkdf2BatchImpl() << std::endl;
+    if (!verify()) {
+        std::cerr << "batch PBKDF2 output differs from OpenSSL" << std::endl;
+        return 1;
+    }
+    std::cout << "verify: ok (byte-identical to PKCS5_PBKDF2_HMAC)" << std::endl;
+
+    std::vector<std::string> passwords, salts;
+    for (size_t i = 0; i < count; ++i) {
+        passwords.push_back("password" + std::to_string(i));
+        salts.push_back(randomBytes(16));
+    }
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i) opensslKey(passwords[i], salts[i], iterations);
+    double openssl_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    std::vector<std::string> keys;
+    pbkdf2Sha256Batch(passwords, salts, iterations, keys);
+    double batch_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "hashes: " << count << ", iterations: " << iterations << "\n"
+              << "openssl: " << count / openssl_s << " hashes/s/core\n"
+              << "batch:   " << count / batch_s << " hashes/s/core\n"
+              << std::setprecision(2) << "speedup: " << openssl_s / batch_s << "x" << std::endl;
+    return 0;
+}
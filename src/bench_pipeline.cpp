@@ -0,0 +1,288 @@
+// Бенчмарк конвейера libpq: последовательные запросы против одного конвейера на канале
+// с заметной задержкой. Между бенчмарком и PostgreSQL встаёт TCP-прокси, который задерживает
+// данные на rtt/2 в каждую сторону, так что цена лишнего сетевого круга видна и на localhost.
+// Запуск (запросы встроены в бинарник через queries.h):
+//   ./bench_pipeline ["dbname=students_db user=admin password=admin host=localhost"] [rtt_ms=5]
+// Создаёт временную группу/курс/студентов/занятия, замеряет и удаляет их за собой.
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "async_db.h"
+#include "db.h"
+#include "queries.h"
+
+using Clock = std::chrono::steady_clock;
+
+// ----------------- Прокси с задержкой -----------------
+
+// Пересылает байты from -> to, выдерживая каждый кусок delay от момента чтения
+static void pump(int from, int to, Clock::duration delay) {
+    struct Chunk {
+        Clock::time_point due;
+        std::string data;
+    };
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Chunk> queue;
+    bool eof = false;
+
+    std::thread writer([&] {
+        for (;;) {
+            Chunk c;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [&] { return eof || !queue.empty(); });
+                if (queue.empty()) break;
+                c = std::move(queue.front());
+                queue.pop_front();
+            }
+            std::this_thread::sleep_until(c.due);
+            for (size_t off = 0; off < c.data.size();) {
+                ssize_t n = send(to, c.data.data() + off, c.data.size() - off, MSG_NOSIGNAL);
+                if (n <= 0) return;
+                off += n;
+            }
+        }
+        shutdown(to, SHUT_WR);
+    });
+
+    char buf[64 * 1024];
+    for (ssize_t n; (n = recv(from, buf, sizeof(buf), 0)) > 0;) {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push_back({Clock::now() + delay, std::string(buf, n)});
+        cv.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        eof = true;
+        cv.notify_one();
+    }
+    writer.join();
+}
+
+static int connectTo(const std::string &host, const std::string &port) {
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0) throw std::runtime_error("Cannot resolve " + host);
+    int fd = -1;
+    for (auto *ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) throw std::runtime_error("Cannot connect to " + host + ":" + port);
+    return fd;
+}
+
+// Слушает 127.0.0.1:<случайный порт>; соединения живут до конца процесса
+static int startDelayProxy(std::string host, std::string port, Clock::duration one_way) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&addr), len) != 0 || listen(listener, 64) != 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &len) != 0)
+        throw std::runtime_error("Cannot start delay proxy");
+
+    std::thread([=] {
+        for (int client; (client = accept(listener, nullptr, nullptr)) >= 0;) {
+            int upstream;
+            try {
+                upstream = connectTo(host, port);
+            } catch (const std::exception &e) {
+                std::cerr << "proxy: " << e.what() << std::endl;
+                close(client);
+                continue;
+            }
+            int one = 1;
+            setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            setsockopt(upstream, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            std::thread(pump, client, upstream, one_way).detach();
+            std::thread(pump, upstream, client, one_way).detach();
+        }
+    }).detach();
+    return ntohs(addr.sin_port);
+}
+
+// host/port из строки подключения (по умолчанию localhost:5432)
+static void upstreamOf(const std::string &conn_str, std::string &host, std::string &port) {
+    host = "localhost";
+    port = "5432";
+    char *err = nullptr;
+    PQconninfoOption *opts = PQconninfoParse(conn_str.c_str(), &err);
+    if (!opts) {
+        std::string msg = err ? err : "invalid connection string";
+        PQfreemem(err);
+        throw std::runtime_error(msg);
+    }
+    for (auto *o = opts; o->keyword; ++o) {
+        if (!o->val || !*o->val) continue;
+        if (std::string(o->keyword) == "host") host = o->val;
+        if (std::string(o->keyword) == "port") port = o->val;
+    }
+    PQconninfoFree(opts);
+}
+
+// ----------------- Фикстура -----------------
+
+struct Fixture {
+    int group_id = 0;
+    int course_id = 0;
+    std::string prefix;
+};
+
+static Fixture seed(Database &db, int students, int lessons) {
+    Fixture f;
+    f.prefix = "bench_" + std::to_string(getpid());
+
+    auto conn = db.acquire();
+    pqxx::work txn(*conn);
+    f.group_id = txn.exec("INSERT INTO groups (name) VALUES (" + txn.quote(f.prefix) + ") RETURNING id")[0][0].as<int>();
+    f.course_id = txn.exec("INSERT INTO courses (name) VALUES (" + txn.quote(f.prefix) + ") RETURNING id")[0][0].as<int>();
+    std::string gid = std::to_string(f.group_id), cid = std::to_string(f.course_id);
+
+    txn.exec("INSERT INTO users (login, password_hash, role, first_name, last_name) "
+             "SELECT " + txn.quote(f.prefix + "_") + " || i, 'x', 'STUDENT', 'Имя' || i, 'Фамилия' || i "
+             "FROM generate_series(1, " + std::to_string(students) + ") i");
+    txn.exec("INSERT INTO students (user_id, group_id) SELECT id, " + gid + " FROM users "
+             "WHERE login LIKE " + txn.quote(f.prefix + "\\_%"));
+    txn.exec("INSERT INTO lessons (course_id, group_id, lesson_date) "
+             "SELECT " + cid + ", " + gid + ", DATE '2025-09-01' + i "
+             "FROM generate_series(0, " + std::to_string(lessons - 1) + ") i");
+    txn.exec("INSERT INTO grades (student_id, lesson_id, score, absent) "
+             "SELECT s.id, l.id, (1 + floor(random() * 5))::smallint, false "
+             "FROM students s JOIN lessons l ON l.group_id = s.group_id AND l.course_id = " + cid + " "
+             "WHERE s.group_id = " + gid + " AND random() < 0.7");
+    txn.commit();
+    return f;
+}
+
+static void cleanup(Database &db, const Fixture &f) {
+    auto conn = db.acquire();
+    pqxx::work txn(*conn);
+    // Логины и студентов из add_student тоже начинаются с префикса
+    txn.exec("DELETE FROM users WHERE login LIKE " + txn.quote(f.prefix + "\\_%"));
+    txn.exec("DELETE FROM courses WHERE id = " + std::to_string(f.course_id));
+    txn.exec("DELETE FROM groups WHERE id = " + std::to_string(f.group_id));
+    txn.commit();
+}
+
+// ----------------- Варианты -----------------
+
+// Журнал как до конвейера: BEGIN, три запроса и COMMIT по очереди
+static Task<void> journalSequential(AsyncDatabase &adb, asio::io_context &io, const Fixture &f) {
+    auto conn = co_await adb.acquire(io);
+    co_await conn->exec("BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY");
+    co_await conn.query(q::get_journal_lessons, f.course_id, f.group_id);
+    co_await conn.query(q::get_students_by_group_, f.group_id);
+    co_await conn.query(q::get_journal_grades, f.course_id, f.group_id);
+    co_await conn->exec("COMMIT");
+}
+
+static Task<void> journalPipeline(AsyncDatabase &adb, asio::io_context &io, const Fixture &f) {
+    JsonWriter out(16 * 1024);
+    co_await adb.writeJournal(io, f.course_id, f.group_id, out);
+}
+
+// Добавление студента как в Database::addStudent: id пользователя нужен второму INSERT
+static Task<void> addStudentSequential(AsyncDatabase &adb, asio::io_context &io, const Fixture &f, int n) {
+    auto conn = co_await adb.acquire(io);
+    co_await conn->exec("BEGIN");
+    auto r = co_await conn.query(q::insert_user, f.prefix + "_seq" + std::to_string(n), std::string("x"),
+                                 std::string("STUDENT"), std::string("Имя"), std::string("Фамилия"));
+    co_await conn.query(q::insert_student, r.asInt(0, 0), std::string("2005-01-01"), f.group_id);
+    co_await conn->exec("COMMIT");
+}
+
+static Task<void> addStudentPipeline(AsyncDatabase &adb, asio::io_context &io, const Fixture &f, int n) {
+    Student s{};
+    s.first_name = "Имя";
+    s.last_name = "Фамилия";
+    s.dob = "2005-01-01";
+    s.group_id = f.group_id;
+    co_await adb.addStudent(io, s, f.prefix + "_pipe" + std::to_string(n), "x");
+}
+
+// Задержки всех повторов в мс; задача выполняется на io.run()
+template <typename F>
+static std::vector<double> measure(asio::io_context &io, F &&make, int reps) {
+    std::vector<double> ms;
+    std::exception_ptr error;
+    // Лямбда-корутина хранит ссылку на себя: объект должен жить до конца io.run()
+    auto body = [&]() -> Task<void> {
+        try {
+            co_await make(0); // прогрев: соединение и подготовка запросов
+            for (int i = 1; i <= reps; ++i) {
+                auto start = Clock::now();
+                co_await make(i);
+                ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+    };
+    spawn(body());
+    io.restart();
+    io.run();
+    if (error) std::rethrow_exception(error);
+    std::sort(ms.begin(), ms.end());
+    return ms;
+}
+
+int main(int argc, char **argv) {
+    std::string conn_str = argc > 1 ? argv[1] : "dbname=students_db user=admin password=admin host=localhost";
+    int rtt_ms = argc > 2 ? std::max(0, std::stoi(argv[2])) : 5;
+
+    try {
+        Database db(conn_str, 1);
+        std::string host, port;
+        upstreamOf(conn_str, host, port);
+        int proxy_port = startDelayProxy(host, port, std::chrono::microseconds(rtt_ms * 500));
+        // Повторные ключи в строке подключения libpq перекрывают предыдущие
+        std::string delayed = conn_str + " host=127.0.0.1 port=" + std::to_string(proxy_port);
+
+        asio::io_context io;
+        AsyncDatabase adb(delayed, queryStatements(), 1);
+
+        Fixture f = seed(db, 30, 40);
+        const int reps = 50;
+        std::cout << "rtt_ms=" << rtt_ms << std::endl;
+        std::cout << std::left << std::setw(14) << "operation" << std::setw(12) << "variant"
+                  << std::setw(14) << "round_trips" << std::setw(10) << "p50_ms" << "p99_ms" << std::endl;
+        auto row = [](const char *op, const char *variant, int round_trips, const std::vector<double> &ms) {
+            std::cout << std::setw(14) << op << std::setw(12) << variant << std::setw(14) << round_trips
+                      << std::fixed << std::setprecision(2) << std::setw(10) << ms[ms.size() / 2]
+                      << ms[std::min(ms.size() - 1, ms.size() * 99 / 100)] << std::endl;
+        };
+
+        try {
+            row("journal", "sequential", 5, measure(io, [&](int) { return journalSequential(adb, io, f); }, reps));
+            row("journal", "pipeline", 1, measure(io, [&](int) { return journalPipeline(adb, io, f); }, reps));
+            row("add_student", "sequential", 4, measure(io, [&](int n) { return addStudentSequential(adb, io, f, n); }, reps));
+            row("add_student", "pipeline", 1, measure(io, [&](int n) { return addStudentPipeline(adb, io, f, n); }, reps));
+        } catch (...) {
+            cleanup(db, f);
+            throw;
+        }
+        cleanup(db, f);
+    } catch (const std::exception &e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
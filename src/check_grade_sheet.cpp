@@ -0,0 +1,100 @@
+// Проверка журнала группы (GET /teacher/courses/<c>/groups/<g>/grades) на живой БД:
+// создаёт группу с двумя студентами и двумя занятиями, ставит оценку "5" и пропуск "Н",
+// строит ответ тем же путём, что и обработчик (getGroupGradeSheet -> gradeSheetJson),
+// и сверяет оценки по датам. Данные удаляются за собой.
+//   ./check_grade_sheet ["dbname=students_db user=admin password=admin host=localhost"]
+// Код возврата 1, если ответ не совпал или запрос упал.
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "db.h"
+
+struct Fixture {
+    int group_id = 0;
+    int course_id = 0;
+    std::string prefix;
+};
+
+static Fixture seed(Database &db) {
+    Fixture f;
+    f.prefix = "check_" + std::to_string(getpid());
+
+    auto conn = db.acquire();
+    pqxx::work txn(*conn);
+    f.group_id = txn.exec("INSERT INTO groups (name) VALUES (" + txn.quote(f.prefix) + ") RETURNING id")[0][0].as<int>();
+    f.course_id = txn.exec("INSERT INTO courses (name) VALUES (" + txn.quote(f.prefix) + ") RETURNING id")[0][0].as<int>();
+    std::string gid = std::to_string(f.group_id), cid = std::to_string(f.course_id);
+
+    // Студенты <prefix>_1 ("Фамилия1 Имя1") и <prefix>_2, занятия 2025-09-01 и 2025-09-02
+    txn.exec("INSERT INTO users (login, password_hash, role, first_name, last_name) "
+             "SELECT " + txn.quote(f.prefix + "_") + " || i, 'x', 'STUDENT', 'Имя' || i, 'Фамилия' || i "
+             "FROM generate_series(1, 2) i");
+    txn.exec("INSERT INTO students (user_id, group_id) SELECT id, " + gid + " FROM users "
+             "WHERE login LIKE " + txn.quote(f.prefix + "\\_%"));
+    txn.exec("INSERT INTO lessons (course_id, group_id, lesson_date) "
+             "VALUES (" + cid + ", " + gid + ", DATE '2025-09-01'), (" + cid + ", " + gid + ", DATE '2025-09-02')");
+
+    // Первому студенту: 5 за первое занятие и пропуск второго; второму — ничего
+    txn.exec("INSERT INTO grades (student_id, lesson_id, score, absent) "
+             "SELECT s.id, l.id, CASE WHEN l.lesson_date = DATE '2025-09-01' THEN 5 END, l.lesson_date = DATE '2025-09-02' "
+             "FROM students s JOIN users u ON u.id = s.user_id JOIN lessons l ON l.group_id = s.group_id "
+             "WHERE u.login = " + txn.quote(f.prefix + "_1") + " AND l.course_id = " + cid);
+    txn.commit();
+    return f;
+}
+
+static void cleanup(Database &db, const Fixture &f) {
+    auto conn = db.acquire();
+    pqxx::work txn(*conn);
+    txn.exec("DELETE FROM users WHERE login LIKE " + txn.quote(f.prefix + "\\_%"));
+    txn.exec("DELETE FROM courses WHERE id = " + std::to_string(f.course_id));
+    txn.exec("DELETE FROM groups WHERE id = " + std::to_string(f.group_id));
+    txn.commit();
+}
+
+// Ожидаемый ответ; первый студент в списке — Фамилия1 (студенты отсортированы по фамилии)
+static int verify(const crow::json::rvalue &res) {
+    int failures = 0;
+    auto expect = [&](bool ok, const std::string &what) {
+        std::cout << (ok ? "OK    " : "FAIL  ") << what << std::endl;
+        if (!ok) ++failures;
+    };
+
+    expect(res.has("dates") && res["dates"].size() == 2, "two lesson dates");
+    expect(res.has("students") && res["students"].size() == 2, "two students");
+    if (failures) return failures;
+
+    auto &first = res["students"][0];
+    auto &second = res["students"][1];
+    expect(std::string(first["student_name"].s()) == "Фамилия1 Имя1", "students ordered by last name");
+    expect(first.has("grades") && first["grades"].has("2025-09-01") &&
+               std::string(first["grades"]["2025-09-01"].s()) == "5", "stored score 5 returned as \"5\"");
+    expect(first.has("grades") && first["grades"].has("2025-09-02") &&
+               std::string(first["grades"]["2025-09-02"].s()) == "Н", "absence returned as \"Н\"");
+    expect(!second.has("grades"), "student without grades has no grades");
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    std::string conn_str = argc > 1 ? argv[1] : "dbname=students_db user=admin password=admin host=localhost";
+
+    try {
+        Database db(conn_str, 1);
+        Fixture f = seed(db);
+        int failures;
+        try {
+            auto body = gradeSheetJson(db.getGroupGradeSheet(f.course_id, f.group_id)).dump();
+            auto res = crow::json::load(body);
+            if (!res) throw std::runtime_error("invalid JSON: " + body);
+            failures = verify(res);
+        } catch (...) {
+            cleanup(db, f);
+            throw;
+        }
+        cleanup(db, f);
+        return failures == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+}
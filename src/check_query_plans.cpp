@@ -0,0 +1,123 @@
+// Проверка планов: каждый запрос из queries.sql должен находить строки по индексу.
+// Запросы и миграции встроены при сборке, запускать можно из любого каталога:
+//   ./check_query_plans ["dbname=students_db user=admin password=admin host=localhost"]
+//
+// В одной транзакции (в конце откатывается): миграции -> тестовые данные -> ANALYZE ->
+// для каждого запроса EXPLAIN (FORMAT JSON) общего плана с enable_seqscan = off.
+// Нарушение — Seq Scan или обход индекса целиком (Index Scan без Index Cond), т.е. для условия
+// запроса подходящего индекса нет. Полные выборки списков (FULL_LISTINGS) допускаются.
+// Код возврата 1, если есть нарушения или запрос не удалось подготовить/объяснить (BROKEN).
+#include <iostream>
+#include <iomanip>
+#include <set>
+#include <string>
+#include <vector>
+#include "db.h"
+#include "migrations.h"
+#include "queries.h"
+
+// Запросы, которые по смыслу читают таблицу целиком
+static const std::set<std::string> FULL_LISTINGS = {
+    "get_all_users", "get_all_students", "get_all_groups", "get_all_courses",
+    "get_admin_teachers", "get_all_teacher_loads", "get_all_teachers", "sync_teachers",
+};
+
+static void seed(pqxx::transaction_base &txn) {
+    txn.exec("INSERT INTO groups (name) SELECT 'plancheck_g' || i FROM generate_series(1, 20) i");
+    txn.exec("INSERT INTO courses (name) SELECT 'plancheck_c' || i FROM generate_series(1, 10) i");
+    txn.exec("INSERT INTO users (login, password_hash, role, first_name, last_name) "
+             "SELECT 'plancheck_s' || i, 'x', 'STUDENT', 'Имя' || i, 'Фамилия' || i FROM generate_series(1, 500) i");
+    txn.exec("INSERT INTO users (login, password_hash, role, first_name, last_name) "
+             "SELECT 'plancheck_t' || i, 'x', 'TEACHER', 'Имя' || i, 'Фамилия' || i FROM generate_series(1, 20) i");
+    txn.exec("INSERT INTO students (user_id, group_id, dob) "
+             "SELECT u.id, g.id, DATE '2005-01-01' + (u.id % 365) FROM users u "
+             "JOIN groups g ON g.name = 'plancheck_g' || (1 + u.id % 20) WHERE u.login LIKE 'plancheck\\_s%'");
+    txn.exec("INSERT INTO teachers (user_id) SELECT id FROM users WHERE login LIKE 'plancheck\\_t%'");
+    txn.exec("INSERT INTO teacher_courses (teacher_id, course_id, group_id) "
+             "SELECT u.id, c.id, g.id FROM users u "
+             "JOIN courses c ON c.name = 'plancheck_c' || (1 + u.id % 10) "
+             "JOIN groups g ON g.name LIKE 'plancheck\\_g%' AND g.id % 4 = u.id % 4 "
+             "WHERE u.login LIKE 'plancheck\\_t%'");
+    txn.exec("INSERT INTO lessons (course_id, group_id, lesson_date, homework) "
+             "SELECT c.id, g.id, DATE '2025-09-01' + d, '' FROM courses c "
+             "JOIN groups g ON g.name LIKE 'plancheck\\_g%' CROSS JOIN generate_series(0, 19) d "
+             "WHERE c.name LIKE 'plancheck\\_c%'");
+    txn.exec("INSERT INTO grades (student_id, lesson_id, score, absent) "
+             "SELECT s.id, l.id, CASE WHEN (s.id + l.id) % 10 = 0 THEN NULL ELSE 1 + (s.id + l.id) % 5 END, "
+             "(s.id + l.id) % 10 = 0 FROM students s "
+             "JOIN lessons l ON l.group_id = s.group_id "
+             "JOIN groups g ON g.id = s.group_id AND g.name LIKE 'plancheck\\_g%' "
+             "WHERE (s.id + l.id) % 10 < 7");
+    txn.exec("ANALYZE");
+}
+
+// Обход дерева плана: Seq Scan и Index Scan без условия по индексу
+static void findScans(const crow::json::rvalue &node, std::vector<std::string> &problems) {
+    std::string type = node["Node Type"].s();
+    std::string relation = node.has("Relation Name") ? std::string(node["Relation Name"].s()) : "";
+
+    if (type == "Seq Scan") {
+        problems.push_back("Seq Scan on " + relation);
+    } else if ((type == "Index Scan" || type == "Index Only Scan") && !node.has("Index Cond")) {
+        problems.push_back("full scan of index " + std::string(node["Index Name"].s()) + " on " + relation);
+    }
+
+    if (node.has("Plans")) {
+        for (auto &child : node["Plans"]) findScans(child, problems);
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string conn_str = argc > 1 ? argv[1] : "dbname=students_db user=admin password=admin host=localhost";
+
+    try {
+        pqxx::connection conn(conn_str);
+        runMigrations(conn);
+
+        pqxx::work txn(conn);
+        seed(txn);
+        txn.exec("SET LOCAL enable_seqscan = off");
+        txn.exec("SET LOCAL plan_cache_mode = force_generic_plan");
+
+        size_t violations = 0, broken = 0, n = 0;
+        for (const QueryInfo &query : q::all) {
+            std::string name = query.name, sql = query.sql;
+            std::string stmt = "plancheck_" + std::to_string(++n);
+            std::vector<std::string> problems;
+            try {
+                // Подтранзакция: запрос с ошибкой не обрывает всю проверку
+                pqxx::subtransaction sub(txn, stmt);
+                sub.exec("PREPARE " + stmt + " AS " + sql);
+                std::string args;
+                for (int i = 0; i < query.arity; ++i) args += i ? ", NULL" : "(NULL";
+                if (query.arity) args += ")";
+
+                auto plan = crow::json::load(sub.exec("EXPLAIN (FORMAT JSON) EXECUTE " + stmt + args)[0][0].as<std::string>());
+                sub.exec("DEALLOCATE " + stmt);
+                sub.commit();
+                findScans(plan[0]["Plan"], problems);
+            } catch (const std::exception &e) {
+                ++broken;
+                std::cout << std::left << std::setw(34) << name << "BROKEN  " << e.what() << std::endl;
+                continue;
+            }
+
+            const char *status = "OK";
+            if (!problems.empty()) {
+                if (FULL_LISTINGS.count(name)) status = "FULL";
+                else { status = "NO INDEX"; ++violations; }
+            }
+            std::cout << std::left << std::setw(34) << name << status;
+            for (auto &p : problems) std::cout << "  [" << p << "]";
+            std::cout << std::endl;
+        }
+        txn.abort();
+
+        std::cout << "\nstatements: " << std::size(q::all) << ", without index: " << violations
+                  << ", broken: " << broken << std::endl;
+        return violations == 0 && broken == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 2;
+    }
+}
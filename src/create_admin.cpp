@@ -24,7 +24,7 @@ int main() {
         );
 
         // Создаём нового
-        txn.exec_prepared(
+        txn.exec_params(
             "INSERT INTO users (login, password_hash, role) VALUES ($1, $2, $3)",
             login,
             hash,
@@ -1,9 +1,13 @@
 #include "crypto.h"
+#include "pbkdf2_simd.h"
 #include <openssl/evp.h>
 #include <openssl/rand.h>
+#include <openssl/crypto.h>
 #include <iomanip>
 #include <sstream>
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
 
 std::string bytesToHex(const unsigned char* bytes, size_t len) {
     std::ostringstream oss;
@@ -53,4 +57,113 @@ bool checkPassword(const std::string& password, const std::string& stored) {
                       EVP_sha256(), hashLen, testHash);
 
     return CRYPTO_memcmp(hash, testHash, hashLen) == 0;
-}
\ No newline at end of file
+}
+
+// ----------------- Пакетный PBKDF2 -----------------
+
+namespace {
+
+enum class Pbkdf2Impl { Scalar, Avx2, Avx512 };
+
+// Выбор ядра по возможностям CPU; PBKDF2_SIMD=avx2|scalar позволяет понизить уровень
+Pbkdf2Impl detectImpl() {
+    Pbkdf2Impl impl = Pbkdf2Impl::Scalar;
+#ifdef HAVE_PBKDF2_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) impl = Pbkdf2Impl::Avx512;
+    else if (__builtin_cpu_supports("avx2")) impl = Pbkdf2Impl::Avx2;
+#endif
+    if (const char *env = std::getenv("PBKDF2_SIMD")) {
+        std::string want = env;
+        if (want == "scalar") impl = Pbkdf2Impl::Scalar;
+        else if (want == "avx2" && impl == Pbkdf2Impl::Avx512) impl = Pbkdf2Impl::Avx2;
+    }
+    return impl;
+}
+
+Pbkdf2Impl batchImpl() {
+    static const Pbkdf2Impl impl = detectImpl();
+    return impl;
+}
+
+// Ключ HMAC: пароль длиннее блока заменяется его SHA-256, затем дополняется нулями до 64 байт
+void hmacKey(const std::string &password, unsigned char key[64]) {
+    std::memset(key, 0, 64);
+    if (password.size() > 64) {
+        unsigned int len = 0;
+        EVP_Digest(password.data(), password.size(), key, &len, EVP_sha256(), nullptr);
+    } else {
+        std::memcpy(key, password.data(), password.size());
+    }
+}
+
+} // namespace
+
+const char *pbkdf2BatchImpl() {
+    switch (batchImpl()) {
+        case Pbkdf2Impl::Avx512: return "avx512";
+        case Pbkdf2Impl::Avx2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+void pbkdf2Sha256Batch(const std::vector<std::string> &passwords, const std::vector<std::string> &salts,
+                       int iterations, std::vector<std::string> &keys) {
+    const int saltLen = PBKDF2_SALT_LEN;
+    const int hashLen = PBKDF2_HASH_LEN;
+    const size_t n = passwords.size();
+    keys.assign(n, std::string(hashLen, '\0'));
+
+    Pbkdf2Impl impl = batchImpl();
+    if (impl == Pbkdf2Impl::Scalar) {
+        for (size_t i = 0; i < n; ++i) {
+            PKCS5_PBKDF2_HMAC(passwords[i].c_str(), passwords[i].length(),
+                              reinterpret_cast<const unsigned char *>(salts[i].data()), saltLen, iterations,
+                              EVP_sha256(), hashLen, reinterpret_cast<unsigned char *>(&keys[i][0]));
+        }
+        return;
+    }
+
+    const size_t lanes = impl == Pbkdf2Impl::Avx512 ? PBKDF2_AVX512_LANES : PBKDF2_AVX2_LANES;
+    std::vector<unsigned char> keyBuf(lanes * 64), saltBuf(lanes * saltLen), outBuf(lanes * hashLen);
+
+    for (size_t base = 0; base < n; base += lanes) {
+        // Неполная последняя пачка добивается копиями последнего пароля
+        for (size_t l = 0; l < lanes; ++l) {
+            size_t i = std::min(base + l, n - 1);
+            hmacKey(passwords[i], &keyBuf[l * 64]);
+            std::memcpy(&saltBuf[l * saltLen], salts[i].data(), saltLen);
+        }
+
+        auto *k = reinterpret_cast<const unsigned char (*)[64]>(keyBuf.data());
+        auto *sl = reinterpret_cast<const unsigned char (*)[PBKDF2_SALT_LEN]>(saltBuf.data());
+        auto *out = reinterpret_cast<unsigned char (*)[PBKDF2_HASH_LEN]>(outBuf.data());
+        if (impl == Pbkdf2Impl::Avx512) pbkdf2Sha256Avx512(k, sl, iterations, out);
+        else pbkdf2Sha256Avx2(k, sl, iterations, out);
+
+        for (size_t l = 0; l < lanes && base + l < n; ++l) {
+            std::memcpy(&keys[base + l][0], &outBuf[l * hashLen], hashLen);
+        }
+    }
+    OPENSSL_cleanse(keyBuf.data(), keyBuf.size());
+}
+
+std::vector<std::string> hashPasswords(const std::vector<std::string> &passwords) {
+    const int saltLen = 16;
+    const int iterations = 100000;
+
+    std::vector<std::string> salts(passwords.size(), std::string(saltLen, '\0'));
+    for (auto &salt : salts)
+        RAND_bytes(reinterpret_cast<unsigned char *>(&salt[0]), saltLen);
+
+    std::vector<std::string> keys;
+    pbkdf2Sha256Batch(passwords, salts, iterations, keys);
+
+    std::vector<std::string> res;
+    res.reserve(passwords.size());
+    for (size_t i = 0; i < passwords.size(); ++i) {
+        res.push_back(bytesToHex(reinterpret_cast<const unsigned char *>(salts[i].data()), saltLen) + ":" +
+                      bytesToHex(reinterpret_cast<const unsigned char *>(keys[i].data()), keys[i].size()));
+    }
+    return res;
+}
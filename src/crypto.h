@@ -1,5 +1,20 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <cstddef>
 
 std::string hashPassword(const std::string &password);
 bool checkPassword(const std::string &password, const std::string &hash);
+
+// Пакетное хеширование (массовое создание аккаунтов): результат в том же формате salt:hash,
+// что и hashPassword, но пароли считаются параллельно в дорожках AVX2/AVX-512
+std::vector<std::string> hashPasswords(const std::vector<std::string> &passwords);
+
+// PBKDF2-HMAC-SHA256 для пачки паролей: соли по 16 байт, ключи по 32 байта
+void pbkdf2Sha256Batch(const std::vector<std::string> &passwords, const std::vector<std::string> &salts,
+                       int iterations, std::vector<std::string> &keys);
+
+// Реализация пакетного PBKDF2 на этом CPU: "avx512", "avx2" или "scalar" (OpenSSL)
+const char *pbkdf2BatchImpl();
+
+std::string bytesToHex(const unsigned char *bytes, size_t len);
@@ -1,166 +1,50 @@
 #include "db.h"
+#include "migrations.h"
+#include "queries.h"
 #include <stdexcept>
 #include <algorithm>
 #include <unordered_map>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <mutex>
+#include <thread>
 #include <crow.h>
 
-std::string trim(const std::string& str) {
-    size_t first = str.find_first_not_of(" \t\n\r");
-    if (std::string::npos == first) return str;
-    size_t last = str.find_last_not_of(" \t\n\r");
-    return str.substr(first, (last - first + 1));
+std::vector<std::pair<std::string, std::string>> queryStatements() {
+    std::vector<std::pair<std::string, std::string>> statements;
+    for (const QueryInfo &query : q::all) statements.emplace_back(query.name, query.sql);
+    return statements;
 }
 
-Database::Database(const std::string &conn_str) : conn(conn_str) {
-    // Инициализация таблиц
-    try {
-        pqxx::work txn(conn);
-
-        // 1. Таблица Users
-        txn.exec(R"(
-            CREATE TABLE IF NOT EXISTS users (
-                id SERIAL PRIMARY KEY,
-                login VARCHAR(50) UNIQUE NOT NULL,
-                password_hash VARCHAR(255) NOT NULL,
-                role VARCHAR(20) NOT NULL,
-                first_name VARCHAR(100),
-                last_name VARCHAR(100)
-            );
-        )");
-
-        // 2. Таблица Groups
-        txn.exec(R"(
-            CREATE TABLE IF NOT EXISTS groups (
-                id SERIAL PRIMARY KEY,
-                name VARCHAR(50) UNIQUE NOT NULL
-            );
-        )");
-
-        // 3. Таблица Students
-        txn.exec(R"(
-            CREATE TABLE IF NOT EXISTS students (
-                id SERIAL PRIMARY KEY,
-                user_id INT NOT NULL REFERENCES users(id) ON DELETE CASCADE,
-                group_id INT REFERENCES groups(id) ON DELETE SET NULL,
-                dob DATE
-            );
-        )");
-
-        // 4. Таблица Teachers
-        txn.exec(R"(
-            CREATE TABLE IF NOT EXISTS teachers (
-                id SERIAL PRIMARY KEY,
-                user_id INT NOT NULL REFERENCES users(id) ON DELETE CASCADE
-            );
-        )");
-
-        // 5. Таблица Courses
-        txn.exec(R"(
-            CREATE TABLE IF NOT EXISTS courses (
-                id SERIAL PRIMARY KEY,
-                name VARCHAR(100) NOT NULL
-            );
-        )");
-
-        // 6. Таблица Teacher_Courses (Нагрузка)
-        txn.exec(R"(
-            CREATE TABLE IF NOT EXISTS teacher_courses (
-                id SERIAL PRIMARY KEY,
-                teacher_id INT NOT NULL REFERENCES users(id) ON DELETE CASCADE,
-                course_id INT NOT NULL REFERENCES courses(id) ON DELETE CASCADE,
-                group_id INT NOT NULL REFERENCES groups(id) ON DELETE CASCADE,
-                CONSTRAINT unique_load UNIQUE (teacher_id, course_id, group_id)
-            );
-        )");
-
-        // 7. Таблица Lessons
-        txn.exec(R"(
-            CREATE TABLE IF NOT EXISTS lessons (
-                id SERIAL PRIMARY KEY,
-                course_id INT NOT NULL REFERENCES courses(id) ON DELETE CASCADE,
-                group_id INT NOT NULL REFERENCES groups(id) ON DELETE CASCADE,
-                lesson_date DATE NOT NULL,
-                homework TEXT
-            );
-        )");
-
-        // 8. Таблица Grades
-        txn.exec(R"(
-            CREATE TABLE IF NOT EXISTS grades (
-                student_id INT NOT NULL REFERENCES students(id) ON DELETE CASCADE,
-                lesson_id INT NOT NULL REFERENCES lessons(id) ON DELETE CASCADE,
-                grade VARCHAR(5),
-                PRIMARY KEY (student_id, lesson_id)
-            );
-        )");
-
-        txn.commit();
-        std::cout << "[INFO] Database schema initialized." << std::endl;
+// Размер пула по умолчанию: по одному соединению на ядро (как и потоков у Crow)
+static size_t defaultPoolSize() {
+    size_t n = std::thread::hardware_concurrency();
+    return n < 2 ? 2 : n;
+}
 
+Database::Database(const std::string &conn_str, size_t pool_size)
+    : pool(conn_str, pool_size == 0 ? defaultPoolSize() : pool_size) {
+    // Схема: новые встроенные миграции (см. migrations.h). Без них запросы каталога
+    // не подготовятся, поэтому ошибка останавливает запуск
+    try {
+        auto conn = pool.acquire();
+        runMigrations(*conn);
     }
     catch (const std::exception& e) {
         std::cerr << "[CRITICAL] Failed to init DB schema: " << e.what() << std::endl;
+        throw;
     }
 
-
-    // 1. Открываем файл с запросами
-    std::ifstream file("queries.sql");// файл queries.sql должен лежать рядом с исполняемым файлом
-    
-    if (!file.is_open()) {
-        throw std::runtime_error("FATAL ERROR: Could not open queries.sql! Make sure the file exists.");
-    }
-
-    std::string line;
-    std::string currentName;
-    std::string currentQuery;
-
-    while (std::getline(file, line)) {
-        // Убираем лишние пробелы по краям
-        std::string trimmed = trim(line);
-        if (trimmed.empty()) continue; // пропускаем пустые строки
-
-        // Проверяем, "это имя запроса?" (начинается с "-- name:")
-        if (trimmed.rfind("-- name:", 0) == 0) {
-            // Если у нас уже был накоплен запрос, сохраняем его
-            if (!currentName.empty() && !currentQuery.empty()) {
-                try {
-                    conn.prepare(currentName, currentQuery);
-                } catch (const std::exception& e) {
-                    std::cerr << "Error preparing " << currentName << ": " << e.what() << std::endl;
-                }
-            }
-
-            // Начинаем новый запрос
-            currentName = trim(trimmed.substr(8));// "-- name: my_query" -> (длина 8 символов)
-            currentQuery = "";
-        } 
-        else {
-            // это часть SQL запроса, добавляем к строке
-            currentQuery += line + " ";
-        }
-    }
-
-    // Сохраняем самый последний запрос в файле
-    if (!currentName.empty() && !currentQuery.empty()) {
-        try {
-            conn.prepare(currentName, currentQuery);
-        } catch (const std::exception& e) {
-            std::cerr << "Error preparing " << currentName << ": " << e.what() << std::endl;
-        }
-    }
+    // Каждое соединение пула (и каждое переоткрытое) получает весь каталог запросов
+    pool.prepareAll(queryStatements());
+    std::cout << "[INFO] Connection pool ready, max size " << pool.maxSize() << std::endl;
 }
 
 // Админ-панель
 
 // Получение пользователя по логину
 User Database::getUserByLogin(const std::string &login) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
-    auto r = txn.exec_prepared("get_user_by_login", login);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_user_by_login, login);
     
     // Сначала проверяем и извлекаем данные
     if (r.empty()) {
@@ -181,9 +65,10 @@ User Database::getUserByLogin(const std::string &login) {
 
 // Добавление пользователя (Админ)
 int Database::addUser(const User& u) {
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
     // Выполняем запрос и сохраняем результат
-    auto r = txn.exec_prepared("insert_user", 
+    auto r = execQuery(txn, q::insert_user, 
         u.login, 
         u.password_hash, 
         u.role, 
@@ -198,10 +83,9 @@ int Database::addUser(const User& u) {
 
 // Получение всех пользователей
 std::vector<User> Database::getAllUsers() {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    
-    pqxx::work txn(conn);
-    auto r = txn.exec_prepared("get_all_users");
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_all_users);
     std::vector<User> users;
     for (auto row : r) {
         users.push_back(User{ 
@@ -217,54 +101,184 @@ std::vector<User> Database::getAllUsers() {
     return users;
 }
 
+static void writeUserRow(JsonWriter &out, const pqxx::row &row) {
+    out.beginObject();
+    out.key("id").number(row["id"]);
+    out.key("login").string(row["login"]);
+    out.key("role").string(row["role"]);
+    out.key("first_name").string(row["first_name"]);
+    out.key("last_name").string(row["last_name"]);
+    out.endObject();
+}
+
+// Запрос страницы берёт limit + 1 строк: лишняя строка означает, что есть продолжение
+template <typename WriteRow>
+static void writePage(const pqxx::result &r, const PageRequest &page, JsonWriter &out, WriteRow writeRow) {
+    size_t n = std::min(r.size(), static_cast<size_t>(page.limit));
+    out.beginObject();
+    out.key("items").beginArray();
+    for (size_t i = 0; i < n; ++i) writeRow(out, r[i]);
+    out.endArray();
+    out.key("next_after_id");
+    if (r.size() > n) out.number(r[n - 1]["id"]);
+    else out.null();
+    out.endObject();
+}
+
+void Database::writeAllUsers(JsonWriter &out) {
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_all_users);
+    out.beginArray();
+    for (auto row : r) writeUserRow(out, row);
+    out.endArray();
+    txn.commit();
+}
+
+void Database::writeUsersPage(const PageRequest &page, JsonWriter &out) {
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_users_page, page.after_id, page.limit + 1);
+    txn.commit();
+    writePage(r, page, out, writeUserRow);
+}
+
 // Удаление пользователя
 void Database::deleteUser(int id) {
-    pqxx::work txn(conn);
-    txn.exec_prepared("delete_user", id);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    execQuery(txn, q::delete_user, id);
     txn.commit();
+    // Вместе с пользователем каскадно удаляется и его профиль студента
+    studentCache.clear();
+    studentIdByLogin.clear();
 }
 
-// Обновление данных пользователя
+// Обновление данных пользователя: пустые поля не меняются, пароль — если передан хеш
 void Database::updateUser(int id, const User &u) {
-    pqxx::work txn(conn);
-    txn.exec_prepared("update_user", u.login, u.password_hash, u.role, id);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    execQuery(txn, q::update_user, u.login, u.role, u.first_name, u.last_name, id);
+    if (!u.password_hash.empty()) execQuery(txn, q::update_user_password, u.password_hash, id);
     txn.commit();
+    studentCache.clear();
+    studentIdByLogin.clear();
 }
 
 // Обновление пароля пользователя
 void Database::updateUserPassword(int id, const std::string &new_hash) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
     
     // Выполняем запрос из файла
-    txn.exec_prepared("update_user_password", new_hash, id);
+    execQuery(txn, q::update_user_password, new_hash, id);
     
     txn.commit();
 }
 
 // Добавление студента
 void Database::addStudent(const Student &s, std::string login, std::string password) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
 
     // Создаем юзера
-    auto r = txn.exec_prepared("insert_user", login, password, "STUDENT", s.first_name, s.last_name);
+    auto r = execQuery(txn, q::insert_user, login, password, "STUDENT", s.first_name, s.last_name);
     int new_user_id = r[0][0].as<int>();
 
     // Создаем студента
-    txn.exec_prepared("insert_student", new_user_id, s.dob, s.group_id);
+    execQuery(txn, q::insert_student, new_user_id, s.dob, s.group_id);
     
     txn.commit();
 }
 
+// Массовое добавление студентов (все или никто)
+void Database::addStudents(const std::vector<Student> &students, const std::vector<std::string> &logins, const std::vector<std::string> &password_hashes) {
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+
+    for (size_t i = 0; i < students.size(); ++i) {
+        const Student &s = students[i];
+        auto r = execQuery(txn, q::insert_user, logins[i], password_hashes[i], "STUDENT", s.first_name, s.last_name);
+        execQuery(txn, q::insert_student, r[0][0].as<int>(), s.dob, s.group_id);
+    }
+
+    txn.commit();
+}
+
+// Массовый импорт студентов через COPY FROM STDIN
+StudentMergeStats Database::importStudents(const std::vector<StudentImportRow> &rows, const std::vector<std::string> &password_hashes,
+                                           const std::function<void(size_t copied)> &progress) {
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+
+    txn.exec(R"(
+        CREATE TEMP TABLE student_import (
+            login TEXT,
+            password_hash TEXT,
+            first_name TEXT,
+            last_name TEXT,
+            dob TEXT,
+            group_name TEXT
+        ) ON COMMIT DROP
+    )");
+
+    // Строки уходят в Postgres потоком COPY, без отдельного INSERT на каждую
+    {
+        auto stream = pqxx::stream_to::table(txn, {"student_import"},
+                                             {"login", "password_hash", "first_name", "last_name", "dob", "group_name"});
+        for (size_t i = 0; i < rows.size(); ++i) {
+            const auto &r = rows[i];
+            stream << std::make_tuple(r.login, password_hashes[i], r.first_name, r.last_name, r.dob, r.group);
+            if (progress && (i + 1) % 1000 == 0) progress(i + 1);
+        }
+        stream.complete();
+        if (progress) progress(rows.size());
+    }
+
+    // Слияние одним запросом: пользователи (существующие логины пропускаем),
+    // затем студенты только для созданных пользователей; группа — по названию или id
+    auto r = txn.exec(R"(
+        WITH new_users AS (
+            INSERT INTO users (login, password_hash, role, first_name, last_name)
+            SELECT login, password_hash, 'STUDENT', first_name, last_name FROM student_import
+            ON CONFLICT (login) DO NOTHING
+            RETURNING id, login
+        ), new_students AS (
+            INSERT INTO students (user_id, dob, group_id)
+            SELECT nu.id, NULLIF(si.dob, '')::date,
+                   (SELECT g.id FROM groups g
+                    WHERE g.name = si.group_name
+                       OR g.id = CASE WHEN si.group_name ~ '^[0-9]+$' THEN si.group_name::int END
+                    ORDER BY g.name = si.group_name DESC
+                    LIMIT 1)
+            FROM new_users nu
+            JOIN student_import si ON si.login = nu.login
+            RETURNING group_id
+        )
+        SELECT (SELECT COUNT(*) FROM new_users) AS users_created,
+               COUNT(*) AS students_created,
+               COUNT(*) FILTER (WHERE group_id IS NULL) AS without_group
+        FROM new_students
+    )");
+
+    txn.commit();
+
+    StudentMergeStats stats{};
+    stats.inserted = r[0]["students_created"].as<size_t>();
+    stats.skipped_existing = rows.size() - r[0]["users_created"].as<size_t>();
+    stats.without_group = r[0]["without_group"].as<size_t>();
+    return stats;
+}
+
 // Обновление пароля в ЛК студента
 void Database::updatePasswordByStudentId(int student_id, const std::string& new_hash) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
 
-    auto result = txn.exec_prepared("update_password_by_student_id", new_hash, student_id);
+    auto result = execQuery(txn, q::update_password_by_student_id, new_hash, student_id);
 
     txn.commit();
+    studentCache.erase(student_id);
 
     if (result.affected_rows() == 0) {
         throw std::runtime_error("Student not found or password not updated");
@@ -273,10 +287,10 @@ void Database::updatePasswordByStudentId(int student_id, const std::string& new_
 
 // Получение всех студентов
 std::vector<Student> Database::getAllStudents() {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
 
-    auto r = txn.exec_prepared("get_all_students");
+    auto r = execQuery(txn, q::get_all_students);
 
     std::vector<Student> students;
     for (auto row : r) {
@@ -297,10 +311,67 @@ std::vector<Student> Database::getAllStudents() {
     return students;
 }
 
+static void writeStudentRow(JsonWriter &out, const pqxx::row &row) {
+    out.beginObject();
+    out.key("id").number(row["id"]);
+    out.key("first_name").string(row["first_name"], "—");
+    out.key("last_name").string(row["last_name"], "—");
+    out.key("login").string(row["login"], "—");
+    out.key("dob").string(row["dob"], "—");
+    out.key("group_id").number(row["group_id"], "0");
+    out.endObject();
+}
+
+void Database::writeAllStudents(JsonWriter &out) {
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_all_students);
+    out.beginArray();
+    for (auto row : r) writeStudentRow(out, row);
+    out.endArray();
+    txn.commit();
+}
+
+void Database::writeStudentsPage(const PageRequest &page, JsonWriter &out) {
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_students_page, page.after_id, page.limit + 1);
+    txn.commit();
+    writePage(r, page, out, writeStudentRow);
+}
+
+static void writeTeacherRow(JsonWriter &out, const pqxx::row &row) {
+    out.beginObject();
+    out.key("id").number(row["id"]);
+    out.key("first_name").string(row["first_name"]);
+    out.key("last_name").string(row["last_name"]);
+    out.key("login").string(row["login"]);
+    // Если групп нет, придет null -> заменим на прочерк
+    out.key("groups").string(row["group_names"], "—");
+    out.endObject();
+}
+
+void Database::writeAdminTeachers(JsonWriter &out) {
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_admin_teachers);
+    out.beginArray();
+    for (auto row : r) writeTeacherRow(out, row);
+    out.endArray();
+    txn.commit();
+}
+
+void Database::writeAdminTeachersPage(const PageRequest &page, JsonWriter &out) {
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_admin_teachers_page, page.after_id, page.limit + 1);
+    txn.commit();
+    writePage(r, page, out, writeTeacherRow);
+}
+
 // Получение списка студентов группы
-std::vector<Student> Database::getStudentsByGroup(int group_id) {
-    pqxx::work txn(conn);
-    auto r = txn.exec_prepared("get_students_by_group", group_id);
+std::vector<Student> Database::readStudentsByGroup(pqxx::transaction_base &txn, int group_id) {
+    auto r = execQuery(txn, q::get_students_by_group, group_id);
     
     std::vector<Student> students;
     for (auto row : r) {
@@ -316,25 +387,26 @@ std::vector<Student> Database::getStudentsByGroup(int group_id) {
 
         students.push_back(s);
     }
+    return students;
+}
+
+std::vector<Student> Database::getStudentsByGroup(int group_id) {
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto students = readStudentsByGroup(txn, group_id);
     txn.commit();
     return students;
 }
 
 // Удаление студента
 void Database::deleteStudent(int student_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
     try {
-        // Сначала узнаем user_id этого студента
-        auto r = txn.exec_prepared("get_user_id_by_student", student_id);
-        
-        if (!r.empty()) {
-            int user_id = r[0][0].as<int>();
-
-            // Удаляем самого пользователя. 
-            txn.exec_prepared("delete_user_by_id", user_id);
-            txn.commit();
-        }
+        // Пользователь студента ищется подзапросом; профиль удаляется каскадом
+        execQuery(txn, q::delete_student_user, student_id);
+        txn.commit();
+        studentCache.erase(student_id);
     } catch (const std::exception& e) {
         std::cerr << "Ошибка удаления: " << e.what() << std::endl;
         throw;
@@ -343,46 +415,88 @@ void Database::deleteStudent(int student_id) {
 
 // Обновление информации о студенте
 void Database::updateStudent(int id, const Student &s) {
-    pqxx::work txn(conn);
-    txn.exec_prepared("update_student", s.first_name, s.last_name, s.dob, s.group_id, id);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    execQuery(txn, q::update_student, s.dob, s.group_id, id);
+    execQuery(txn, q::update_student_user, s.first_name, s.last_name, id);
     txn.commit();
+    studentCache.erase(id);
+}
+
+static Student studentFromRow(const pqxx::row &row) {
+    Student s;
+    s.id = row["id"].as<int>();
+    s.user_id = row["user_id"].as<int>();
+    s.first_name = row["first_name"].as<std::string>("");
+    s.last_name = row["last_name"].as<std::string>("");
+    s.login = row["login"].as<std::string>("");
+    s.dob = row["dob"].as<std::string>("");
+    s.group_id = row["group_id"].as<int>(0);
+    return s;
 }
 
 // Получение профиля студента по ID
 Student Database::getStudentByUserId(int user_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
-    auto r = txn.exec_prepared("get_student_by_user_id", user_id); 
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_student_by_user_id, user_id); 
 
     if (r.empty()) {
         throw std::runtime_error("Student profile not found");
     }
 
-    Student s;
-    s.id = r[0]["id"].as<int>();
-    s.user_id = r[0]["user_id"].as<int>();
-    s.first_name = r[0]["first_name"].as<std::string>("");
-    s.last_name = r[0]["last_name"].as<std::string>("");
-    s.login = r[0]["login"].as<std::string>("");
-    s.dob = r[0]["dob"].as<std::string>("");
-    s.group_id = r[0]["group_id"].as<int>(0);
-
+    Student s = studentFromRow(r[0]);
     txn.commit();
     return s;
 }
 
+// Студент по первичному ключу; повторные открытия профиля берутся из LRU
+Student Database::getStudentById(int id) {
+    if (auto cached = studentCache.get(id)) return *cached;
+
+    uint64_t epoch = studentCache.epoch();
+    auto conn = pool.acquire();
+    pqxx::read_transaction txn(*conn);
+    auto r = execQuery(txn, q::get_student_by_id, id);
+    if (r.empty()) throw std::runtime_error("Student not found");
+
+    Student s = studentFromRow(r[0]);
+    studentCache.put(id, s, epoch);
+    return s;
+}
+
+Student Database::getStudentByLogin(const std::string &login) {
+    if (auto id = studentIdByLogin.get(login)) {
+        Student s = getStudentById(*id);
+        if (s.login == login) return s;
+    }
+
+    uint64_t epoch = studentCache.epoch();
+    uint64_t login_epoch = studentIdByLogin.epoch();
+    auto conn = pool.acquire();
+    pqxx::read_transaction txn(*conn);
+    auto r = execQuery(txn, q::get_student_by_login, login);
+    if (r.empty()) throw std::runtime_error("Student not found");
+
+    Student s = studentFromRow(r[0]);
+    studentCache.put(s.id, s, epoch);
+    studentIdByLogin.put(login, s.id, login_epoch);
+    return s;
+}
+
 // Добавление группы
 void Database::addGroup(const Group &g) {
-    pqxx::work txn(conn);
-    txn.exec_prepared("insert_group", g.name);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    execQuery(txn, q::insert_group, g.name);
     txn.commit();
 }
 
 // Получение списка групп
 std::vector<Group> Database::getAllGroups() {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
-    auto r = txn.exec_prepared("get_all_groups");
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_all_groups);
     std::vector<Group> groups;
     for (auto row : r) {
         groups.push_back(Group{ row["id"].as<int>(), row["name"].as<std::string>() });
@@ -393,26 +507,27 @@ std::vector<Group> Database::getAllGroups() {
 
 // Получение группы по ID
 Group Database::getGroupById(int id) {
-    pqxx::work txn(conn);
-    auto r = txn.exec_prepared("get_group_by_id", id);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_group_by_id, id);
     if (r.empty()) throw std::runtime_error("Group not found");
     return Group{ r[0]["id"].as<int>(), r[0]["name"].as<std::string>() };
 }
 
 // Добавление предмета
 void Database::addCourse(const Course &c) {
-    pqxx::work txn(conn);
-    txn.exec_prepared("insert_course", c.name);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    execQuery(txn, q::insert_course, c.name);
     txn.commit();
 }
 
 // Получение списка предметов
 std::vector<Course> Database::getAllCourses() {
-    std::lock_guard<std::mutex> lock(db_mutex); 
-    
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
     try {
-        auto r = txn.exec_prepared("get_all_courses");
+        auto r = execQuery(txn, q::get_all_courses);
         
         std::vector<Course> courses;
         for (auto row : r) {
@@ -434,31 +549,33 @@ std::vector<Course> Database::getAllCourses() {
 
 // Удаление предмета
 void Database::deleteCourse(int id) {
-    pqxx::work txn(conn);
-    txn.exec_prepared("delete_course", id);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    execQuery(txn, q::delete_course, id);
     txn.commit();
 }
 
 // Обновление информации о предмете
 void Database::updateCourse(int id, const Course &c) {
-    pqxx::work txn(conn);
-    txn.exec_prepared("update_course", c.name, id);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    execQuery(txn, q::update_course, c.name, id);
     txn.commit();
 }
 
 // Связь оценка и студента
 std::vector<Grade> Database::getGradesByStudent(int student_id) {
-    pqxx::work txn(conn);
-    auto r = txn.exec_prepared("get_grades_by_student", student_id);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_grades_by_student, student_id);
     
     std::vector<Grade> grades;
     for (auto row : r) {
-        std::string grade_str = row["grade"].is_null() ? "Н" : row["grade"].as<std::string>();
-        bool present = (grade_str != "Н"); // если "Н" — отсутствовал
+        bool present = !row["absent"].as<bool>(); // "Н" — отсутствовал
         grades.push_back(Grade{
             row["student_id"].as<int>(),
             row["course_id"].as<int>(),
-            present ? std::stoi(grade_str) : 0,
+            row["score"].as<int>(0),
             present,
             row["lesson_date"].as<std::string>()
         });
@@ -467,42 +584,58 @@ std::vector<Grade> Database::getGradesByStudent(int student_id) {
     return grades;
 }
 
+// Оценки не ниже 1, поэтому 0.0 у студентов без оценок ставит их в конец (как NULLS LAST)
+void sortGroupRating(std::vector<StudentRating> &rating) {
+    std::stable_sort(rating.begin(), rating.end(),
+                     [](const StudentRating &a, const StudentRating &b) { return a.avg_grade > b.avg_grade; });
+}
+
+// Рейтинг группы: суммы и количества оценок уже посчитаны в student_stats,
+// остаётся поделить и отсортировать список размером с группу
+std::vector<StudentRating> Database::readGroupRating(pqxx::transaction_base &txn, int student_id) {
+    auto r = execQuery(txn, q::get_group_rating, student_id);
+
+    std::vector<StudentRating> rating;
+    rating.reserve(r.size());
+    for (auto row : r) {
+        int count = row["score_count"].is_null() ? 0 : row["score_count"].as<int>();
+        double avg = count ? static_cast<double>(row["score_sum"].as<int>()) / count : 0.0;
+        rating.push_back({row["id"].as<int>(), row["first_name"].as<std::string>(),
+                          row["last_name"].as<std::string>(), avg});
+    }
+
+    sortGroupRating(rating);
+    return rating;
+}
+
 // Получение рейтинга группы
 crow::json::wvalue Database::getGroupRating(int student_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
-    
-    auto r = txn.exec_prepared("get_group_rating", student_id);
-    
+    auto conn = pool.acquire();
+    pqxx::read_transaction txn(*conn);
+    auto rating = readGroupRating(txn, student_id);
+    txn.commit();
+
     crow::json::wvalue res = crow::json::wvalue::list();
-    for (size_t i = 0; i < r.size(); ++i) {
-        res[i]["first_name"] = r[i][0].as<std::string>();
-        res[i]["last_name"] = r[i][1].as<std::string>();
-        // Если оценок нет, возвращаем 0.0
-        res[i]["average_grade"] = r[i][2].is_null() ? 0.0 : r[i][2].as<double>();
+    for (size_t i = 0; i < rating.size(); ++i) {
+        res[i]["first_name"] = rating[i].first_name;
+        res[i]["last_name"] = rating[i].last_name;
+        res[i]["average_grade"] = rating[i].avg_grade;
     }
     return res;
 }
 
 // Получение списка группы
 crow::json::wvalue Database::getGroupList(int student_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
-    
-    // Сначала узнаем group_id самого студента
-    auto res_group = txn.exec_prepared("SELECT group_id FROM students WHERE id = $1", student_id);
-    if (res_group.empty()) return crow::json::wvalue::list();
-    int group_id = res_group[0][0].as<int>();
-
-    // Получаем список всех студентов этой группы с их средним баллом
-    auto r = txn.exec_prepared("get_group_list_avg", group_id);
+    auto conn = pool.acquire();
+    pqxx::read_transaction txn(*conn);
+    auto rating = readGroupRating(txn, student_id);
+    txn.commit();
 
     crow::json::wvalue::list students_list;
-    for (auto row : r) {
+    for (auto &st : rating) {
         crow::json::wvalue s;
-        s["name"] = row[0].as<std::string>() + " " + row[1].as<std::string>();
-        // Если оценок нет, avg() вернет null, обрабатываем это:
-        s["average_grade"] = row[2].is_null() ? 0.0 : row[2].as<double>();
+        s["name"] = st.first_name + " " + st.last_name;
+        s["average_grade"] = st.avg_grade;
         students_list.push_back(std::move(s));
     }
     return students_list;
@@ -510,11 +643,11 @@ crow::json::wvalue Database::getGroupList(int student_id) {
 
 // Связь преподавателя и предмета
 std::vector<TeacherCourse> Database::getTeacherCourses(int user_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
     
     // Используем user_id напрямую
-    auto r = txn.exec_prepared("get_teacher_courses", user_id);
+    auto r = execQuery(txn, q::get_teacher_courses, user_id);
     
     std::vector<TeacherCourse> res;
     for (auto row : r) {
@@ -526,10 +659,10 @@ std::vector<TeacherCourse> Database::getTeacherCourses(int user_id) {
 
 // Связь группы учителя с предметом
 std::vector<CourseGroup> Database::getTeacherGroupsForCourse(int course_id, int user_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
     
-    auto r = txn.exec_prepared("get_teacher_groups_for_course", course_id, user_id);
+    auto r = execQuery(txn, q::get_teacher_groups_for_course, course_id, user_id);
     
     std::vector<CourseGroup> res;
     for (auto row : r) {
@@ -540,9 +673,8 @@ std::vector<CourseGroup> Database::getTeacherGroupsForCourse(int course_id, int
 }
 
 // Получение урока для таблицы
-std::vector<Lesson> Database::getLessons(int course_id, int group_id) {
-    pqxx::work txn(conn);
-    auto r = txn.exec_prepared("get_lessons", course_id, group_id);
+std::vector<Lesson> Database::readLessons(pqxx::transaction_base &txn, int course_id, int group_id) {
+    auto r = execQuery(txn, q::get_lessons, course_id, group_id);
     
     std::vector<Lesson> res;
     for (auto row : r) {
@@ -551,32 +683,37 @@ std::vector<Lesson> Database::getLessons(int course_id, int group_id) {
             row["lesson_date"].as<std::string>()
         });
     }
+    return res;
+}
+
+std::vector<Lesson> Database::getLessons(int course_id, int group_id) {
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto res = readLessons(txn, course_id, group_id);
     txn.commit();
     return res;
 }
 
 // Получение таблицы оценок по курсу и группе
+// Вся сетка студенты × занятия строится одним запросом (LEFT JOIN на grades),
+// пустые ячейки приходят с NULL вместо оценки
 std::vector<GradeCell> Database::getGradeTable(int course_id, int group_id) {
-    pqxx::work txn(conn);
-    
-    auto students_r = txn.exec_prepared("get_students_by_group", group_id);
-    auto lessons_r = txn.exec_prepared("get_lessons", course_id, group_id);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+
+    auto r = execQuery(txn, q::get_grade_table, course_id, group_id);
+
     std::vector<GradeCell> table;
-    for (auto const& s : students_r) {
-        for (auto const& l : lessons_r) {
-            auto grade_r = txn.exec_prepared("get_grade_by_student_lesson", s["id"].as<int>(), l["id"].as<int>());
-            
+    table.reserve(r.size());
+    for (auto const& row : r) {
+        table.push_back({
+            row["student_id"].as<int>(),
+            row["first_name"].as<std::string>() + " " + row["last_name"].as<std::string>(),
+            row["lesson_id"].as<int>(),
+            row["lesson_date"].as<std::string>(),
             // Если в базе NULL или ничего нет, считаем что оценки нет (пробел)
-            std::string grade = grade_r.empty() ? "" : grade_r[0][0].as<std::string>();
-
-            table.push_back({
-                s["id"].as<int>(),
-                s["first_name"].as<std::string>() + " " + s["last_name"].as<std::string>(),
-                l["id"].as<int>(),
-                l["lesson_date"].as<std::string>(),
-                grade
-            });
-        }
+            row["grade"].as<std::string>("")
+        });
     }
     txn.commit();
     return table;
@@ -584,8 +721,9 @@ std::vector<GradeCell> Database::getGradeTable(int course_id, int group_id) {
 
 // Получение списка учителей
 std::vector<Teacher> Database::getAllTeachers() {
-    pqxx::work txn(conn);
-    auto r = txn.exec_prepared("get_all_teachers");
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_all_teachers);
     txn.commit();
     std::unordered_map<int, Teacher> map;
     for (auto row : r) {
@@ -606,16 +744,16 @@ std::vector<Teacher> Database::getAllTeachers() {
 
 // Добавление преподавателя
 void Database::addTeacher(const std::string& login, const std::string& password, const std::string& first_name, const std::string& last_name, const std::vector<int>& group_ids) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
 
     try {
         // Создаем пользователя и получаем его ID
-        auto res_u = txn.exec_prepared("insert_user_teacher", login, password, "TEACHER", first_name, last_name);
+        auto res_u = execQuery(txn, q::insert_user_teacher, login, password, "TEACHER", first_name, last_name);
         int new_user_id = res_u[0][0].as<int>();
 
         // Создаем профиль в таблице teachers
-        txn.exec_prepared("insert_teacher_profile", new_user_id);
+        execQuery(txn, q::insert_teacher_profile, new_user_id);
 
         txn.commit();
     } catch (const std::exception &e) {
@@ -626,36 +764,37 @@ void Database::addTeacher(const std::string& login, const std::string& password,
 
 // Обновление информации о преподавателе
 void Database::updateTeacher(int id, const Teacher& t) {
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
 
-    txn.exec_prepared("update_teacher_user", t.login, t.first_name, t.last_name, id);
+    execQuery(txn, q::update_teacher_user, t.login, t.first_name, t.last_name, id);
 
     for (int gid : t.group_ids)
-        txn.exec_prepared("insert_teacher_group", id, gid);
+        execQuery(txn, q::insert_teacher_group, id, gid);
 
     txn.commit();
 }
 
 // Удаление преподавателя
 void Database::deleteTeacher(int teacher_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
     
     // Получаем user_id, чтобы удалить и профиль, и аккаунт
-    auto r = txn.exec_prepared("get_user_id_by_teacher", teacher_id);
+    auto r = execQuery(txn, q::get_user_id_by_teacher, teacher_id);
     if (!r.empty()) {
         int user_id = r[0][0].as<int>();
-        txn.exec_prepared("delete_user_by_id", user_id);
+        execQuery(txn, q::delete_user_by_id, user_id);
         txn.commit();
     }
 }
 
 // Связь преподавателя и пользователя 
 Teacher Database::getTeacherByUserId(int user_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
     
-    auto r = txn.exec_prepared("get_teacher_base_info", user_id);
+    auto r = execQuery(txn, q::get_teacher_base_info, user_id);
     
     if (r.empty()) {
         throw std::runtime_error("Teacher profile not found for user_id=" + std::to_string(user_id));
@@ -674,95 +813,258 @@ Teacher Database::getTeacherByUserId(int user_id) {
 
 // Установка / обновление оценки
 void Database::setGrade(int student_id, int course_id, const std::string& lesson_date, const std::string& grade) {
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
 
-    // Ищем ID урока по дате и предмету
-    auto r = txn.exec_prepared("get_lesson_by_id", course_id, lesson_date);
-    
+    int score;
+    bool absent;
+    if (!parseGrade(grade, score, absent)) throw std::invalid_argument("Invalid grade: " + grade);
+
+    // Урок по дате и предмету ищется в том же INSERT: один запрос вместо двух
+    auto r = execQuery(txn, q::upsert_grade_by_date, student_id, course_id, lesson_date, score, absent);
     if (r.empty()) {
         throw std::runtime_error("Lesson not found for date: " + lesson_date);
     }
-    
-    int lesson_id = r[0][0].as<int>();
 
-    // Сохраняем или обновляем оценку (grade теперь строка)
-    txn.exec_prepared("upsert_grade", student_id, lesson_id, grade);
-    
     txn.commit();
 }
 
+// Оценка из БД -> GradeEntry (у "Н" score = NULL, для логики это 0)
+static GradeEntry gradeEntryFromRow(const std::string &lesson_date, const pqxx::field &score) {
+    return { lesson_date, score.as<int>(0) };
+}
+
 // Связь оценки между студентом и предетом
 std::vector<GradeEntry>Database::getGradesByStudentAndCourse(int student_id, int course_id) {
-    pqxx::work w(conn);
-    auto r = w.exec_prepared("get_grades_by_student_course", student_id, course_id);
+    auto conn = pool.acquire();
+    pqxx::work w(*conn);
+    auto r = execQuery(w, q::get_grades_by_student_course, student_id, course_id);
 
     std::vector<GradeEntry> res;
     for (auto row : r) {
-        std::string g_str = row[1].is_null() ? "Н" : row[1].as<std::string>();
-        int g_val = (g_str == "Н") ? 0 : std::stoi(g_str); // Н превращаем в 0 для логики
-        res.push_back({ row[0].as<std::string>(), g_val });
+        res.push_back(gradeEntryFromRow(row[0].as<std::string>(), row[1]));
     }
     return res;
 }
 
+// Оценки всей группы по предмету одним запросом: student_id -> оценки
+std::unordered_map<int, std::vector<GradeEntry>> Database::readGroupGrades(pqxx::transaction_base &txn, int group_id, int course_id) {
+    auto r = execQuery(txn, q::get_grades_by_group_course, group_id, course_id);
+
+    std::unordered_map<int, std::vector<GradeEntry>> res;
+    for (auto row : r) {
+        res[row["student_id"].as<int>()].push_back(
+            gradeEntryFromRow(row["lesson_date"].as<std::string>(), row["score"]));
+    }
+    return res;
+}
+
+std::unordered_map<int, std::vector<GradeEntry>> Database::getGradesByGroupAndCourse(int group_id, int course_id) {
+    auto conn = pool.acquire();
+    pqxx::read_transaction txn(*conn);
+    auto res = readGroupGrades(txn, group_id, course_id);
+    txn.commit();
+    return res;
+}
+
+// Журнал группы: студенты, занятия и оценки в одном снимке (REPEATABLE READ, только чтение),
+// всего три запроса независимо от размера группы
+GroupGradeSheet Database::getGroupGradeSheet(int course_id, int group_id) {
+    auto conn = pool.acquire();
+    pqxx::transaction<pqxx::repeatable_read, pqxx::read_only> txn(*conn);
+
+    GroupGradeSheet sheet;
+    sheet.students = readStudentsByGroup(txn, group_id);
+    sheet.lessons = readLessons(txn, course_id, group_id);
+    sheet.grades = readGroupGrades(txn, group_id, course_id);
+
+    txn.commit();
+    return sheet;
+}
+
 // Связь оценки и даты занятия
 void Database::setGradeByDate(int student_id, int course_id, const std::string& date, const std::string& grade) {
-    pqxx::work w(conn);
+    auto conn = pool.acquire();
+    pqxx::work w(*conn);
 
-    auto lesson_res = w.exec_prepared("get_lesson_by_course_date", course_id, date);
+    int score;
+    bool absent;
+    if (!parseGrade(grade, score, absent)) throw std::invalid_argument("Invalid grade: " + grade);
 
-    if (lesson_res.empty()) {
+    auto r = execQuery(w, q::upsert_grade_by_date, student_id, course_id, date, score, absent);
+    if (r.empty()) {
         throw std::runtime_error("Урок на дату " + date + " не найден в базе.");
     }
 
-    int lesson_id = lesson_res[0][0].as<int>();
+    w.commit();
+}
 
-    w.exec_prepared("upsert_grade", student_id, lesson_id, grade);
+std::string gradeText(int score, bool absent) {
+    return absent ? "Н" : std::to_string(score);
+}
 
-    w.commit();
+crow::json::wvalue gradeSheetJson(const GroupGradeSheet &sheet) {
+    crow::json::wvalue res;
+
+    // даты
+    for (size_t i = 0; i < sheet.lessons.size(); ++i)
+        res["dates"][i] = sheet.lessons[i].lesson_date;
+
+    // студенты + оценки
+    for (size_t i = 0; i < sheet.students.size(); ++i) {
+        auto& s = sheet.students[i];
+
+        res["students"][i]["student_id"] = s.id;
+        res["students"][i]["student_name"] =
+            s.last_name + " " + s.first_name;
+
+        // оценки студента
+        auto it = sheet.grades.find(s.id);
+        if (it == sheet.grades.end()) continue;
+
+        for (auto& g : it->second) {
+            res["students"][i]["grades"][g.lesson_date] =
+                g.grade > 0 ? std::to_string(g.grade) : "Н";
+        }
+    }
+    return res;
+}
+
+bool parseGrade(const std::string &grade, int &score, bool &absent) {
+    if (grade == "Н" || grade == "н") {
+        score = 0;
+        absent = true;
+        return true;
+    }
+    if (grade.size() == 1 && grade[0] >= '1' && grade[0] <= '5') {
+        score = grade[0] - '0';
+        absent = false;
+        return true;
+    }
+    return false;
+}
+
+// Литерал массива PostgreSQL: {1,2,3}, {5,NULL}, {t,f}
+template <typename T, typename F>
+static std::string pgArray(const std::vector<T> &items, F &&format) {
+    std::string out = "{";
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (i) out += ',';
+        out += format(items[i]);
+    }
+    out += '}';
+    return out;
+}
+
+// Пакетная запись оценок: один INSERT ... SELECT FROM unnest(...) ON CONFLICT на всю пачку
+// и один DELETE ... USING unnest(...) для стёртых ячеек
+std::vector<std::string> Database::upsertGrades(const std::vector<GradeWrite> &grades) {
+    std::vector<std::string> status(grades.size());
+    std::vector<int> scores(grades.size());
+    std::vector<bool> absent(grades.size());
+
+    // Последняя запись в ячейку побеждает, ранние помечаем как перекрытые
+    std::unordered_map<long long, size_t> last;
+    std::vector<bool> erase(grades.size());
+    for (size_t i = 0; i < grades.size(); ++i) {
+        int score = 0;
+        bool is_absent = false;
+        erase[i] = grades[i].grade.empty();
+        if (!erase[i] && !parseGrade(grades[i].grade, score, is_absent)) {
+            status[i] = "invalid_grade";
+            continue;
+        }
+        scores[i] = score;
+        absent[i] = is_absent;
+        long long key = (static_cast<long long>(grades[i].student_id) << 32) | static_cast<unsigned>(grades[i].lesson_id);
+        auto it = last.find(key);
+        if (it != last.end()) status[it->second] = "duplicate";
+        last[key] = i;
+    }
+
+    // Пустая оценка — стереть ячейку (так teacher.js сохраняет очищенную клетку)
+    std::vector<size_t> batch, erased;
+    for (size_t i = 0; i < grades.size(); ++i) {
+        if (status[i].empty()) (erase[i] ? erased : batch).push_back(i);
+    }
+    if (batch.empty() && erased.empty()) return status;
+
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    pqxx::result r;
+    if (!batch.empty()) {
+        r = execQuery(txn, q::upsert_grades_batch,
+            pgArray(batch, [&](size_t i) { return std::to_string(grades[i].student_id); }),
+            pgArray(batch, [&](size_t i) { return std::to_string(grades[i].lesson_id); }),
+            pgArray(batch, [&](size_t i) { return absent[i] ? std::string("NULL") : std::to_string(scores[i]); }),
+            pgArray(batch, [&](size_t i) { return std::string(absent[i] ? "t" : "f"); }));
+    }
+    if (!erased.empty()) {
+        execQuery(txn, q::delete_grades_batch,
+            pgArray(erased, [&](size_t i) { return std::to_string(grades[i].student_id); }),
+            pgArray(erased, [&](size_t i) { return std::to_string(grades[i].lesson_id); }));
+    }
+    txn.commit();
+
+    // Строки, которых нет в RETURNING, ссылаются на несуществующего студента или урок;
+    // стирание пустой ячейки не ошибка
+    std::unordered_map<long long, bool> applied;
+    for (auto row : r) {
+        long long key = (static_cast<long long>(row[0].as<int>()) << 32) | static_cast<unsigned>(row[1].as<int>());
+        applied[key] = true;
+    }
+    for (auto &[key, i] : last) {
+        status[i] = erase[i] || applied.count(key) ? "ok" : "not_found";
+    }
+    return status;
 }
 
 // Получение оценок студената
-crow::json::wvalue Database::getStudentGrades(int student_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
-    auto r = txn.exec_prepared("get_student_grades", student_id);
-    
-    std::vector<crow::json::wvalue> grades;
+void Database::writeStudentGrades(int student_id, JsonWriter &out) {
+    auto conn = pool.acquire();
+    pqxx::read_transaction txn(*conn);
+    auto r = execQuery(txn, q::get_student_grades, student_id);
+    txn.commit();
+
+    out.beginArray();
     for (auto row : r) {
-        crow::json::wvalue g;
-        g["course_id"] = row["course_id"].as<int>();
-        g["course_name"] = row["course_name"].as<std::string>();
-        g["grade"] = row["grade"].as<std::string>();
-        g["date_assigned"] = row["date_assigned"].as<std::string>(); 
-        grades.push_back(std::move(g));
+        out.beginObject();
+        out.key("course_id").number(row["course_id"]);
+        out.key("course_name").string(row["course_name"]);
+        out.key("grade").string(row["grade"]);
+        out.key("date_assigned").string(row["date_assigned"]);
+        out.endObject();
     }
-    return crow::json::wvalue(grades);
+    out.endArray();
 }
 
 
 // Создание группы
 void Database::addGroup(const std::string& name) {
-    pqxx::work txn(conn);
-    txn.exec_prepared("insert_group", name);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    execQuery(txn, q::insert_group, name);
     txn.commit();
 }
 
 // Удаление группы
 void Database::deleteGroup(int id) {
-    pqxx::work txn(conn);
-    txn.exec_prepared("delete_group", id);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    execQuery(txn, q::delete_group, id);
     txn.commit();
+    // У студентов группы group_id стал NULL
+    studentCache.clear();
 }
 
 // Получение профиля студента
 crow::json::wvalue Database::getStudentProfile(int student_id) {
     try {
-        std::lock_guard<std::mutex> lock(db_mutex);
-        pqxx::work txn(conn);
+        auto conn = pool.acquire();
+        pqxx::work txn(*conn);
 
         // Выполняем запрос (убедитесь, что в queries.sql он есть!)
-        auto r = txn.exec_prepared("get_student_profile", student_id);
+        auto r = execQuery(txn, q::get_student_profile, student_id);
 
         if (r.empty()) {
             return crow::json::wvalue({{"error", "Profile not found in DB"}});
@@ -802,10 +1104,10 @@ crow::json::wvalue Database::getStudentProfile(int student_id) {
 // Получение юзера студента 
 int Database::getStudentIdByUserId(int user_id) {
     try {
-        std::lock_guard<std::mutex> lock(db_mutex);
-        pqxx::work txn(conn);
+        auto conn = pool.acquire();
+        pqxx::work txn(*conn);
         
-        auto r = txn.exec_prepared("get_sid_by_uid", user_id);
+        auto r = execQuery(txn, q::get_sid_by_uid, user_id);
         
         if (r.empty()) {
             return -1; 
@@ -821,21 +1123,18 @@ int Database::getStudentIdByUserId(int user_id) {
 // Получение списка учеников для журнала
 crow::json::wvalue Database::getGroupMembers(int student_id) {
     try {
-        std::lock_guard<std::mutex> lock(db_mutex);
-        pqxx::work txn(conn);
-        
-        // Выполняем обновленный запрос
-        pqxx::result r = txn.exec_prepared("get_group_members", student_id);
-        
+        auto conn = pool.acquire();
+        pqxx::read_transaction txn(*conn);
+        auto rating = readGroupRating(txn, student_id);
+        txn.commit();
+
         std::vector<crow::json::wvalue> members;
-        for (auto row : r) {
+        members.reserve(rating.size());
+        for (auto &st : rating) {
             crow::json::wvalue member;
-            member["first_name"] = row["first_name"].as<std::string>();
-            member["last_name"] = row["last_name"].as<std::string>();
-            
-            // Читаем средний балл. Если оценок нет, база вернет NULL -> заменяем на 0.0
-            member["average_grade"] = row["avg_grade"].is_null() ? 0.0 : row["avg_grade"].as<double>();
-            
+            member["first_name"] = st.first_name;
+            member["last_name"] = st.last_name;
+            member["average_grade"] = st.avg_grade;
             members.push_back(std::move(member));
         }
         return crow::json::wvalue(members);
@@ -848,8 +1147,9 @@ crow::json::wvalue Database::getGroupMembers(int student_id) {
 
 // Получение списка студентов в группе для журнала
 std::vector<crow::json::wvalue> Database::getStudentsInGroup(int group_id) {
-    pqxx::work txn(conn);
-    auto r = txn.exec_prepared("get_students_by_group", group_id);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
+    auto r = execQuery(txn, q::get_students_by_group, group_id);
     std::vector<crow::json::wvalue> students;
     for (auto row : r) {
         crow::json::wvalue s;
@@ -863,25 +1163,21 @@ std::vector<crow::json::wvalue> Database::getStudentsInGroup(int group_id) {
 
 // Добавление учебной нагрузки преподавателю
 void Database::addTeacherLoad(pqxx::work& txn, int tid, int cid, int gid) {
-    txn.exec_prepared("add_teacher_load", tid, cid, gid);
+    execQuery(txn, q::add_teacher_load, tid, cid, gid);
 }
 
 // Прогнозирование оценки
 crow::json::wvalue Database::predictGrade(int student_id, int course_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
-    pqxx::work txn(conn);
+    auto conn = pool.acquire();
+    pqxx::work txn(*conn);
 
     // Получаем оценки от старых к новым
-    auto r = txn.exec_prepared("get_grades_for_predict", student_id, course_id);
+    auto r = execQuery(txn, q::get_grades_for_predict, student_id, course_id);
     
+    // Пропуски ("Н") отфильтрованы в запросе, остаются только баллы
     std::vector<int> grades;
-    for (auto row : r) {
-        std::string g_str = row[0].is_null() ? "Н" : row[0].as<std::string>();
-        // Для прогноза берем только цифры
-        if (g_str != "Н" && !g_str.empty()) {
-            try { grades.push_back(std::stoi(g_str)); } catch (...) {}
-        }
-    }
+    grades.reserve(r.size());
+    for (auto row : r) grades.push_back(row[0].as<int>());
     txn.commit();
 
     crow::json::wvalue res;
@@ -1,9 +1,13 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <functional>
 #include <pqxx/pqxx>
-#include <mutex>
 #include <crow.h>
+#include "pool.h"
+#include "json_writer.h"
+#include "lru_cache.h"
 
 // пользователь
 struct User {
@@ -99,28 +103,117 @@ struct GradeCell {
     std::string grade; // "1".."5" или "Н"
 };
 
+// одна ячейка пакетной записи оценок
+struct GradeWrite {
+    int student_id;
+    int lesson_id;
+    std::string grade; // "1".."5", "Н" или "" (стереть оценку)
+};
+
+// оценка из очереди отложенной записи (GradeQueue), ещё не попавшая в БД
+struct PendingGrade {
+    int student_id;
+    int lesson_id;
+    int score;   // 0, если absent
+    bool absent;
+};
+
+// строка массового импорта студентов (CSV)
+struct StudentImportRow {
+    std::string login;
+    std::string password; // открытый пароль из файла, в БД попадает только хеш
+    std::string first_name;
+    std::string last_name;
+    std::string dob;
+    std::string group;    // название или id группы
+};
+
+// итог слияния импорта в users/students
+struct StudentMergeStats {
+    size_t inserted;
+    size_t skipped_existing;
+    size_t without_group;
+};
+
+// Keyset-пагинация по id: строки с id > after_id, не больше limit.
+// Ответ: {"items": [...], "next_after_id": <id последней строки> | null}
+struct PageRequest {
+    int after_id = 0;
+    int limit = 50;
+};
+
+// журнал группы по предмету, прочитанный в одном снимке
+struct GroupGradeSheet {
+    std::vector<Student> students;
+    std::vector<Lesson> lessons;
+    std::unordered_map<int, std::vector<GradeEntry>> grades; // student_id -> оценки
+};
+
+// Рейтинг группы по убыванию среднего балла (студенты без оценок, avg = 0.0, — в конце)
+void sortGroupRating(std::vector<StudentRating> &rating);
+
+// Все запросы каталога q::all (queries.h, собран из queries.sql): пары (имя, SQL)
+std::vector<std::pair<std::string, std::string>> queryStatements();
+
+// Оценка из API ("1".."5" или "Н") -> хранимый вид (score 1..5 либо absent, score = 0).
+// false, если значение недопустимо.
+bool parseGrade(const std::string &grade, int &score, bool &absent);
+// Обратно: хранимый вид -> "1".."5" или "Н" (как grade_text в SQL)
+std::string gradeText(int score, bool absent);
+
+// Ответ GET /teacher/courses/<c>/groups/<g>/grades: даты занятий и оценки студентов по датам
+crow::json::wvalue gradeSheetJson(const GroupGradeSheet &sheet);
+
 class Database {
-    pqxx::connection conn;
-    std::mutex db_mutex;
+    ConnectionPool pool;
+
+    // Профили студентов по id (и индекс login -> id). Сбрасываются при любом изменении студента
+    // или пользователя; updateUser/deleteUser очищают кеш целиком.
+    LruCache<int, Student> studentCache{4096};
+    LruCache<std::string, int> studentIdByLogin{4096};
+
+    // Чтение внутри уже открытой транзакции (для составных выборок)
+    std::vector<Student> readStudentsByGroup(pqxx::transaction_base &txn, int group_id);
+    std::vector<Lesson> readLessons(pqxx::transaction_base &txn, int course_id, int group_id);
+    std::unordered_map<int, std::vector<GradeEntry>> readGroupGrades(pqxx::transaction_base &txn, int group_id, int course_id);
+    // Группа студента по убыванию среднего балла (из student_stats); без оценок — в конце с 0.0
+    std::vector<StudentRating> readGroupRating(pqxx::transaction_base &txn, int student_id);
 
 public:
-    Database(const std::string &conn_str);
-    std::mutex& getMutex() { return db_mutex; } 
-    pqxx::connection& getConn() { return conn; }
+    // pool_size = 0 -> по числу ядер
+    Database(const std::string &conn_str, size_t pool_size = 0);
+    // Соединение из пула для запросов прямо из обработчиков
+    ConnectionPool::Handle acquire() { return pool.acquire(); }
+    ConnectionPool::Stats poolStats() const { return pool.stats(); }
     // Users
     User getUserByLogin(const std::string &login);
     int addUser(const User &u);
     std::vector<User> getAllUsers();
+    void writeAllUsers(JsonWriter &out); // JSON-массив прямо из результата запроса
+    void writeUsersPage(const PageRequest &page, JsonWriter &out);
     void deleteUser(int id);
     void updateUser(int id, const User &u);
     void updateUserPassword(int id, const std::string &new_hash);
     // Students
     void addStudent(const Student &s, std::string login, std::string password);
+    // Массовое добавление в одной транзакции: logins[i] и password_hashes[i] относятся к students[i]
+    void addStudents(const std::vector<Student> &students, const std::vector<std::string> &logins, const std::vector<std::string> &password_hashes);
+    // Импорт: COPY во временную таблицу и слияние в users/students одной транзакцией
+    StudentMergeStats importStudents(const std::vector<StudentImportRow> &rows, const std::vector<std::string> &password_hashes,
+                                     const std::function<void(size_t copied)> &progress = nullptr);
     std::vector<Student> getAllStudents();
+    void writeAllStudents(JsonWriter &out);
+    void writeStudentsPage(const PageRequest &page, JsonWriter &out);
+    // Преподаватели с перечнем групп (для таблицы администратора)
+    void writeAdminTeachers(JsonWriter &out);
+    void writeAdminTeachersPage(const PageRequest &page, JsonWriter &out);
     std::vector<Student> getStudentsByGroup(int group_id);
     void deleteStudent(int id);
     void updateStudent(int id, const Student &s);
     Student getStudentByUserId(int user_id);
+    // Поиск по первичному ключу / логину через LRU; runtime_error, если студента нет
+    Student getStudentById(int id);
+    Student getStudentByLogin(const std::string &login);
     void updatePasswordByStudentId(int student_id, const std::string& new_hash);
     // Courses
     void addCourse(const Course &c);
@@ -150,10 +243,15 @@ public:
     std::vector<Lesson> getLessons(int course_id, int group_id);
     void setGrade(int student_id, int course_id, const std::string &lesson_date, const std::string &grade);
     std::vector<GradeEntry> getGradesByStudentAndCourse(int student_id, int course_id);
+    std::unordered_map<int, std::vector<GradeEntry>> getGradesByGroupAndCourse(int group_id, int course_id);
+    GroupGradeSheet getGroupGradeSheet(int course_id, int group_id);
     void setGradeByDate(int student_id, int course_id, const std::string &date, const std::string &grade);
+    // Пакетная запись оценок одной транзакцией, пустая оценка стирает ячейку; статус для каждой входной строки:
+    // "ok", "invalid_grade", "not_found" (нет студента/урока) или "duplicate" (перекрыта более поздней строкой)
+    std::vector<std::string> upsertGrades(const std::vector<GradeWrite> &grades);
     void addGroup(const std::string &name);
     void deleteGroup(int id);
-    crow::json::wvalue getStudentGrades(int student_id);
+    void writeStudentGrades(int student_id, JsonWriter &out);
     int getStudentIdByUserId(int user_id);
     crow::json::wvalue getGroupMembers(int student_id);
     std::vector<crow::json::wvalue> getStudentsInGroup(int group_id);
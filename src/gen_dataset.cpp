@@ -0,0 +1,330 @@
+// Синтетическая школа для нагрузочных тестов и проверки масштабирования:
+//   ./gen_dataset [--scale K] [--seed S] [--weeks W] [--grade-rate R] [--absent-rate R]
+//                 [--password P] [--reset] ["dbname=students_db user=admin password=admin host=db"]
+// Масштаб 1 — примерно наш объём: 40 групп по 25 студентов, 12 предметов (по 8 на группу),
+// 30 преподавателей, 18 учебных недель, ~100 тыс. оценок. Группы и преподаватели растут
+// вместе с --scale, так что 10 даёт ~1 млн оценок, 100 — ~10 млн.
+//
+// Один и тот же seed даёт те же данные (свой генератор, без std::*_distribution).
+// Логины: s<seed>_<n> (студенты) и t<seed>_<n> (преподаватели), у всех пароль --password
+// (один хеш PBKDF2 на всех: считать миллион хешей ради теста незачем).
+// Всё пишется одной транзакцией через COPY с явными id и столбцами; суммы student_stats считаются
+// одним INSERT ... SELECT в конце, а не триггером на каждую пачку оценок.
+// --reset очищает пользователей, группы, предметы и всё зависящее от них (TRUNCATE ... CASCADE).
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "crypto.h"
+#include "db.h"
+
+using Clock = std::chrono::steady_clock;
+
+// splitmix64: детерминирован на любой платформе и стандартной библиотеке
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); } // [0, 1)
+    size_t below(size_t n) { return static_cast<size_t>(uniform() * n); }
+
+private:
+    uint64_t state_;
+};
+
+struct Options {
+    int scale = 1;
+    uint64_t seed = 1;
+    int weeks = 18;
+    double grade_rate = 0.30;  // доля (студент, занятие) с оценкой
+    double absent_rate = 0.06; // доля пропусков ("Н")
+    std::string password = "password";
+    bool reset = false;
+    std::string conn_str = "dbname=students_db user=admin password=admin host=db";
+};
+
+static constexpr int GROUPS = 40;
+static constexpr int STUDENTS_PER_GROUP = 25;
+static constexpr int COURSES_PER_GROUP = 8;
+static constexpr int TEACHERS = 30;
+
+static const char *const COURSES[] = {"Математика", "Русский язык", "Литература", "Физика", "Химия", "Биология",
+                                      "История", "Обществознание", "География", "Информатика", "Английский язык",
+                                      "Физкультура"};
+static const char *const MALE_FIRST[] = {"Александр", "Дмитрий", "Максим", "Сергей", "Андрей", "Алексей", "Иван",
+                                         "Артём", "Никита", "Михаил", "Егор", "Илья", "Кирилл", "Роман", "Павел"};
+static const char *const FEMALE_FIRST[] = {"Анастасия", "Мария", "Анна", "Дарья", "Елизавета", "Полина", "Виктория",
+                                           "Екатерина", "Софья", "Александра", "Ксения", "Алиса", "Вероника", "Ольга"};
+static const char *const LAST[] = {"Иванов", "Смирнов", "Кузнецов", "Попов", "Васильев", "Петров", "Соколов",
+                                   "Михайлов", "Новиков", "Фёдоров", "Морозов", "Волков", "Алексеев", "Лебедев",
+                                   "Семёнов", "Егоров", "Павлов", "Козлов", "Степанов", "Николаев", "Орлов"};
+static const char *const HOMEWORK[] = {"§ 12, вопросы 1–4", "Упр. 215", "Задачи 3.14–3.17", "Конспект главы",
+                                       "Выучить определения", "Подготовить доклад"};
+
+template <typename T, size_t N>
+static const T &pick(Rng &rng, const T (&items)[N]) {
+    return items[rng.below(N)];
+}
+
+static std::string formatDate(std::chrono::sys_days day) {
+    std::chrono::year_month_day ymd(day);
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%04d-%02u-%02u", static_cast<int>(ymd.year()), static_cast<unsigned>(ymd.month()),
+                  static_cast<unsigned>(ymd.day()));
+    return buf;
+}
+
+// Текущие наибольшие id: новые строки идут следом, чтобы не зависеть от RETURNING
+static int maxId(pqxx::transaction_base &txn, const std::string &table) {
+    return txn.exec("SELECT COALESCE(MAX(id), 0) FROM " + txn.quote_name(table))[0][0].as<int>();
+}
+
+static void parseArgs(int argc, char **argv, Options &o) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::runtime_error("missing value for " + arg);
+            return argv[++i];
+        };
+        if (arg == "--scale") o.scale = std::max(1, std::atoi(value().c_str()));
+        else if (arg == "--seed") o.seed = std::strtoull(value().c_str(), nullptr, 10);
+        else if (arg == "--weeks") o.weeks = std::max(1, std::atoi(value().c_str()));
+        else if (arg == "--grade-rate") o.grade_rate = std::atof(value().c_str());
+        else if (arg == "--absent-rate") o.absent_rate = std::atof(value().c_str());
+        else if (arg == "--password") o.password = value();
+        else if (arg == "--reset") o.reset = true;
+        else if (arg.rfind("--", 0) == 0) throw std::runtime_error("unknown option " + arg);
+        else o.conn_str = arg;
+    }
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    try {
+        parseArgs(argc, argv, o);
+    } catch (const std::exception &e) {
+        std::cerr << "ERROR: " << e.what() << "\nUsage: " << argv[0]
+                  << " [--scale K] [--seed S] [--weeks W] [--grade-rate R] [--absent-rate R] [--password P] [--reset] [connection string]"
+                  << std::endl;
+        return 2;
+    }
+
+    auto start = Clock::now();
+    auto elapsed = [&] { return std::chrono::duration<double>(Clock::now() - start).count(); };
+    auto stage = [&](const std::string &name, size_t rows) {
+        std::cerr << "[" << static_cast<int>(elapsed() * 1000) / 1000.0 << "s] " << name << ": " << rows << std::endl;
+    };
+
+    const int groups = GROUPS * o.scale;
+    const int teachers = TEACHERS * o.scale;
+    const int courses = static_cast<int>(std::size(COURSES));
+    const std::string seed = std::to_string(o.seed);
+    Rng rng(o.seed);
+
+    try {
+        Database db(o.conn_str, 1); // заодно применяет миграции
+        const std::string hash = hashPassword(o.password);
+
+        auto conn = db.acquire();
+        pqxx::work txn(*conn);
+
+        if (o.reset) {
+            txn.exec("TRUNCATE users, groups, courses RESTART IDENTITY CASCADE");
+            stage("reset", 0);
+        }
+
+        const int user0 = maxId(txn, "users"), group0 = maxId(txn, "groups"), course0 = maxId(txn, "courses");
+        const int student0 = maxId(txn, "students"), teacher0 = maxId(txn, "teachers");
+        const int load0 = maxId(txn, "teacher_courses"), lesson0 = maxId(txn, "lessons");
+
+        // Суммы пересчитываются в конце одним запросом
+        txn.exec("ALTER TABLE grades DISABLE TRIGGER grades_stats_insert");
+
+        // Предметы и группы
+        {
+            auto stream = pqxx::stream_to::table(txn, {"courses"}, {"id", "name"});
+            for (int c = 0; c < courses; ++c) stream << std::make_tuple(course0 + c + 1, std::string(COURSES[c]));
+            stream.complete();
+        }
+        {
+            auto stream = pqxx::stream_to::table(txn, {"groups"}, {"id", "name"});
+            for (int g = 0; g < groups; ++g)
+                stream << std::make_tuple(group0 + g + 1, "Г" + seed + "-" + std::to_string(g + 1));
+            stream.complete();
+        }
+        stage("courses, groups", courses + groups);
+
+        // Пользователи: сначала преподаватели, затем студенты (id подряд)
+        const int students = groups * STUDENTS_PER_GROUP;
+        std::vector<double> ability(students); // средний балл студента, от него зависят оценки
+        {
+            auto stream = pqxx::stream_to::table(txn, {"users"}, {"id", "login", "password_hash", "role", "first_name", "last_name"});
+            for (int t = 0; t < teachers; ++t) {
+                bool female = rng.uniform() < 0.7;
+                std::string last = pick(rng, LAST);
+                stream << std::make_tuple(user0 + t + 1, "t" + seed + "_" + std::to_string(t + 1), hash, std::string("TEACHER"),
+                                          std::string(female ? pick(rng, FEMALE_FIRST) : pick(rng, MALE_FIRST)),
+                                          female ? last + "а" : last);
+            }
+            for (int s = 0; s < students; ++s) {
+                bool female = rng.uniform() < 0.5;
+                std::string last = pick(rng, LAST);
+                stream << std::make_tuple(user0 + teachers + s + 1, "s" + seed + "_" + std::to_string(s + 1), hash,
+                                          std::string("STUDENT"),
+                                          std::string(female ? pick(rng, FEMALE_FIRST) : pick(rng, MALE_FIRST)),
+                                          female ? last + "а" : last);
+                ability[s] = 3.0 + 1.8 * rng.uniform();
+            }
+            stream.complete();
+        }
+        {
+            auto stream = pqxx::stream_to::table(txn, {"teachers"}, {"id", "user_id"});
+            for (int t = 0; t < teachers; ++t) stream << std::make_tuple(teacher0 + t + 1, user0 + t + 1);
+            stream.complete();
+        }
+        {
+            auto stream = pqxx::stream_to::table(txn, {"students"}, {"id", "user_id", "group_id", "dob"});
+            const auto born = std::chrono::sys_days(std::chrono::year(2004) / 1 / 1);
+            for (int s = 0; s < students; ++s) {
+                auto dob = born + std::chrono::days(rng.below(5 * 365));
+                stream << std::make_tuple(student0 + s + 1, user0 + teachers + s + 1, group0 + s / STUDENTS_PER_GROUP + 1,
+                                          formatDate(dob));
+            }
+            stream.complete();
+        }
+        stage("users (teachers + students)", teachers + students);
+
+        // Нагрузка: у группы COURSES_PER_GROUP предметов подряд по кругу от случайного;
+        // предмет ведут преподаватели с t % courses == c, группы между ними по очереди
+        struct Load {
+            int course, group, lessons_per_week;
+        };
+        std::vector<Load> loads;
+        {
+            auto stream = pqxx::stream_to::table(txn, {"teacher_courses"}, {"id", "teacher_id", "course_id", "group_id"});
+            std::vector<int> next_teacher(courses, 0);
+            for (int g = 0; g < groups; ++g) {
+                int first = static_cast<int>(rng.below(courses));
+                for (int k = 0; k < COURSES_PER_GROUP; ++k) {
+                    int c = (first + k) % courses;
+                    int per_course = (teachers - c + courses - 1) / courses; // сколько t с t % courses == c
+                    int t = per_course > 0 ? c + courses * (next_teacher[c]++ % per_course) : g % teachers;
+                    loads.push_back({c, g, c % 3 + 1});
+                    stream << std::make_tuple(load0 + static_cast<int>(loads.size()), user0 + t + 1, course0 + c + 1, group0 + g + 1);
+                }
+            }
+            stream.complete();
+        }
+        stage("teacher_courses", loads.size());
+
+        // Календарь: weeks недель с 1 сентября, занятия по будням; у предмета 1–3 урока в неделю
+        struct LessonRef {
+            int id, group;
+        };
+        std::vector<LessonRef> lessons;
+        {
+            auto stream = pqxx::stream_to::table(txn, {"lessons"}, {"id", "course_id", "group_id", "lesson_date", "homework"});
+            const auto term = std::chrono::sys_days(std::chrono::year(2025) / 9 / 1); // понедельник
+            for (auto &load : loads) {
+                for (int w = 0; w < o.weeks; ++w) {
+                    int day = static_cast<int>(rng.below(5));
+                    for (int k = 0; k < load.lessons_per_week; ++k) {
+                        int id = lesson0 + static_cast<int>(lessons.size()) + 1;
+                        auto date = term + std::chrono::days(w * 7 + (day + k * 2) % 5);
+                        std::optional<std::string> homework;
+                        if (rng.uniform() < 0.3) homework = pick(rng, HOMEWORK);
+                        stream << std::make_tuple(id, course0 + load.course + 1, group0 + load.group + 1, formatDate(date), homework);
+                        lessons.push_back({id, load.group});
+                    }
+                }
+            }
+            stream.complete();
+        }
+        stage("lessons", lessons.size());
+
+        // Разреженная матрица оценок: пропуск, оценка вокруг среднего балла студента или ничего
+        size_t grades = 0, absences = 0;
+        {
+            auto stream = pqxx::stream_to::table(txn, {"grades"}, {"student_id", "lesson_id", "score", "absent"});
+            for (auto &lesson : lessons) {
+                for (int k = 0; k < STUDENTS_PER_GROUP; ++k) {
+                    int s = lesson.group * STUDENTS_PER_GROUP + k;
+                    double r = rng.uniform();
+                    if (r < o.absent_rate) {
+                        stream << std::make_tuple(student0 + s + 1, lesson.id, std::optional<int>(), true);
+                        ++absences;
+                    } else if (r < o.absent_rate + o.grade_rate) {
+                        double noise = rng.uniform() + rng.uniform() - 1.0; // треугольное [-1, 1)
+                        int score = std::clamp(static_cast<int>(ability[s] + 1.5 * noise + 0.5), 1, 5);
+                        stream << std::make_tuple(student0 + s + 1, lesson.id, std::optional<int>(score), false);
+                    } else {
+                        continue;
+                    }
+                    if (++grades % 200000 == 0) stage("grades", grades);
+                }
+            }
+            stream.complete();
+        }
+        stage("grades", grades);
+
+        txn.exec("ALTER TABLE grades ENABLE TRIGGER grades_stats_insert");
+        // Суммы только по новым студентам (старые не затронуты: их оценок мы не писали)
+        txn.exec_params(R"(
+            INSERT INTO student_course_stats (student_id, course_id, score_sum, score_count, absent_count)
+            SELECT g.student_id, l.course_id, COALESCE(SUM(g.score), 0), COUNT(g.score), COUNT(*) FILTER (WHERE g.absent)
+            FROM grades g JOIN lessons l ON l.id = g.lesson_id
+            WHERE g.student_id > $1
+            GROUP BY g.student_id, l.course_id
+        )", student0);
+        txn.exec_params(R"(
+            INSERT INTO student_stats (student_id, score_sum, score_count, absent_count)
+            SELECT student_id, SUM(score_sum), SUM(score_count), SUM(absent_count)
+            FROM student_course_stats
+            WHERE student_id > $1
+            GROUP BY student_id
+        )", student0);
+        stage("student stats", students);
+
+        // Последовательности SERIAL — за явно записанные id
+        for (const char *table : {"users", "groups", "courses", "students", "teachers", "teacher_courses", "lessons"}) {
+            txn.exec("SELECT setval(pg_get_serial_sequence('" + std::string(table) + "', 'id'), "
+                     "GREATEST((SELECT MAX(id) FROM " + std::string(table) + "), 1))");
+        }
+        txn.commit();
+        stage("commit", 0);
+
+        // Статистика планировщика под новый объём (вне транзакции)
+        pqxx::nontransaction analyze(*conn);
+        analyze.exec("ANALYZE users, groups, courses, students, teachers, teacher_courses, lessons, grades, student_stats, student_course_stats");
+        stage("analyze", 0);
+
+        std::cout << "seed:            " << o.seed << "\n"
+                  << "scale:           " << o.scale << "\n"
+                  << "groups:          " << groups << "\n"
+                  << "students:        " << students << " (s" << seed << "_1 .. s" << seed << "_" << students << ")\n"
+                  << "teachers:        " << teachers << " (t" << seed << "_1 .. t" << seed << "_" << teachers << ")\n"
+                  << "courses:         " << courses << "\n"
+                  << "teacher loads:   " << loads.size() << "\n"
+                  << "lessons:         " << lessons.size() << "\n"
+                  << "grades:          " << grades << " (absent " << absences << ")\n"
+                  << "password:        " << o.password << "\n"
+                  << "time:            " << elapsed() << "s" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+// Генератор встроенных миграций: migrations/NNN_описание.sql -> migrations_sql.h (запускается из Makefile).
+//   ./gen_migrations migrations_sql.h migrations/*.sql
+// Файлы попадают в migrations::all по возрастанию NNN, так что сервер и утилиты применяют
+// миграции из своего бинарника и не зависят от рабочего каталога.
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: gen_migrations <migrations_sql.h> <NNN_name.sql>..." << std::endl;
+        return 2;
+    }
+
+    static const std::regex name_re(R"(^(\d+)_[\w-]+\.sql$)");
+    std::map<int, std::pair<std::string, std::string>> files; // номер -> (имя файла, SQL)
+    for (int i = 2; i < argc; ++i) {
+        std::string path = argv[i];
+        std::string name = path.substr(path.find_last_of('/') + 1);
+        std::smatch m;
+        if (!std::regex_match(name, m, name_re)) {
+            std::cerr << path << ": expected NNN_name.sql" << std::endl;
+            return 1;
+        }
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Cannot open " << path << std::endl;
+            return 1;
+        }
+        std::stringstream ss;
+        ss << in.rdbuf();
+        std::string sql = ss.str();
+        if (sql.find(")sql\"") != std::string::npos) {
+            std::cerr << path << ": contains )sql\"" << std::endl;
+            return 1;
+        }
+        if (!files.emplace(std::stoi(m[1]), std::make_pair(name, sql)).second) {
+            std::cerr << path << ": duplicate migration number " << m[1] << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream out(argv[1]);
+    out << "// Сгенерировано gen_migrations из migrations/*.sql — не редактировать вручную\n"
+        << "#pragma once\n"
+        << "#include \"migrations.h\"\n\n"
+        << "namespace migrations {\n\n"
+        << "inline constexpr Migration all[] = {\n";
+    for (auto &[version, file] : files)
+        out << "    {" << version << ", \"" << file.first << "\", R\"sql(" << file.second << ")sql\"},\n";
+    out << "};\n\n} // namespace migrations\n";
+
+    if (!out) {
+        std::cerr << "Cannot write " << argv[1] << std::endl;
+        return 1;
+    }
+    return 0;
+}
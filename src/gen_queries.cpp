@@ -0,0 +1,63 @@
+// Генератор каталога запросов: queries.sql -> queries.h (запускается из Makefile).
+//   ./gen_queries queries.sql queries.h
+// Для каждого блока "-- name: <имя>" в q:: появляется константа Query<N>, где N — число
+// параметров ($1..$N). Опечатка в имени запроса или неверное число аргументов теперь
+// ошибка компиляции, а сервер не читает queries.sql во время работы.
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "query_parser.h"
+
+static bool validName(const std::string &name) {
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) return false;
+    for (char c : name)
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') return false;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: gen_queries <queries.sql> <queries.h>" << std::endl;
+        return 2;
+    }
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    auto statements = parseQueries(in);
+    std::set<std::string> seen;
+    for (auto &st : statements) {
+        st.arity = queryArity(st.sql);
+        if (!validName(st.name) || !seen.insert(st.name).second || st.sql.empty()) {
+            std::cerr << argv[1] << ": invalid, duplicate or empty query \"" << st.name << "\"" << std::endl;
+            return 1;
+        }
+        if (st.sql.find(")sql\"") != std::string::npos) {
+            std::cerr << argv[1] << ": query " << st.name << " contains )sql\"" << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream out(argv[2]);
+    out << "// Сгенерировано gen_queries из queries.sql — не редактировать вручную\n"
+        << "#pragma once\n"
+        << "#include \"query_catalog.h\"\n\n"
+        << "namespace q {\n\n";
+    for (auto &st : statements)
+        out << "inline constexpr Query<" << st.arity << "> " << st.name << "{\"" << st.name << "\", R\"sql(" << st.sql << ")sql\"};\n";
+    out << "\ninline constexpr QueryInfo all[] = {\n";
+    for (auto &st : statements) out << "    " << st.name << ",\n";
+    out << "};\n\n} // namespace q\n";
+
+    if (!out) {
+        std::cerr << "Cannot write " << argv[2] << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,259 @@
+#include "grade_queue.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+
+GradeQueue::GradeQueue(Database &db, Options options) : db_(db), options_(std::move(options)) {
+    if (options_.flush_max == 0) options_.flush_max = 1;
+    fd_ = ::open(options_.journal_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd_ < 0) throw std::runtime_error("Cannot open grade journal " + options_.journal_path + ": " + std::strerror(errno));
+    replay();
+    thread_ = std::thread([this] { flusher(); });
+}
+
+GradeQueue::~GradeQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopping_ = true;
+    }
+    flush_cv_.notify_all();
+    thread_.join();
+    try {
+        flush();
+    } catch (const std::exception &e) {
+        std::cerr << "[WARN] Grade queue: " << size() << " grades left in " << options_.journal_path
+                  << " for next start: " << e.what() << std::endl;
+    }
+    ::close(fd_);
+}
+
+uint64_t GradeQueue::cellKey(int student_id, int lesson_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(student_id)) << 32) | static_cast<uint32_t>(lesson_id);
+}
+
+// Строка журнала "student_id lesson_id score absent"; score = -1 — ячейку записали напрямую,
+// более ранние строки по ней не применять
+static std::string journalRecord(int student_id, int lesson_id, int score, bool absent) {
+    return std::to_string(student_id) + ' ' + std::to_string(lesson_id) + ' ' + std::to_string(score) + ' ' + (absent ? '1' : '0') + '\n';
+}
+
+static bool writeAll(int fd, const std::string &data) {
+    for (size_t off = 0; off < data.size();) {
+        ssize_t n = ::write(fd, data.data() + off, data.size() - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        off += n;
+    }
+    return true;
+}
+
+// Оборванную последнюю строку журнала пропускаем
+void GradeQueue::replay() {
+    FILE *f = fdopen(::dup(fd_), "r");
+    if (!f) throw std::runtime_error("Cannot read grade journal " + options_.journal_path);
+    char line[128];
+    while (std::fgets(line, sizeof(line), f)) {
+        int student_id, lesson_id, score, absent;
+        if (!std::strchr(line, '\n') || std::sscanf(line, "%d %d %d %d", &student_id, &lesson_id, &score, &absent) != 4)
+            continue;
+        uint64_t seq = ++appended_;
+        if (score < 0) pending_.erase(cellKey(student_id, lesson_id));
+        else pending_[cellKey(student_id, lesson_id)] = {{student_id, lesson_id, score, absent != 0}, seq};
+    }
+    std::fclose(f);
+    synced_ = queued_ = appended_;
+    if (!pending_.empty())
+        std::cout << "[INFO] Grade queue: replaying " << pending_.size() << " grades from " << options_.journal_path << std::endl;
+}
+
+// Групповая запись: первый свободный поток пишет и синхронизирует буфер за всех,
+// остальные ждут, пока их seq не окажется на диске
+uint64_t GradeQueue::append(std::unique_lock<std::mutex> &lock, const std::string &records, size_t count) {
+    if (broken_) throw std::runtime_error("Grade journal unavailable");
+
+    appended_ += count;
+    uint64_t seq = appended_;
+    buffer_ += records;
+
+    while (synced_ < seq) {
+        if (broken_) throw std::runtime_error("Grade journal unavailable");
+        if (syncing_) {
+            synced_cv_.wait(lock);
+            continue;
+        }
+        syncing_ = true;
+        std::string data;
+        data.swap(buffer_);
+        uint64_t upto = appended_;
+        lock.unlock();
+
+        bool ok = writeAll(fd_, data) && ::fdatasync(fd_) == 0;
+        if (!ok) std::cerr << "[ERROR] Grade journal write failed: " << std::strerror(errno) << std::endl;
+
+        lock.lock();
+        syncing_ = false;
+        if (ok) synced_ = upto;
+        else broken_ = true;
+        synced_cv_.notify_all();
+    }
+    return seq;
+}
+
+void GradeQueue::put(int student_id, int lesson_id, int score, bool absent) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    uint64_t seq = append(lock, journalRecord(student_id, lesson_id, score, absent), 1);
+
+    // В памяти — только подтверждённое; по seq более поздняя оценка ячейки побеждает
+    auto &cell = pending_[cellKey(student_id, lesson_id)];
+    if (cell.seq < seq) cell = {{student_id, lesson_id, score, absent}, seq};
+    if (++queued_ == synced_) synced_cv_.notify_all(); // checkpoint() ждёт учёта всех записей
+    if (pending_.size() >= options_.flush_max) flush_cv_.notify_one();
+}
+
+void GradeQueue::writeDirect(const std::vector<std::pair<int, int>> &cells, const std::function<void()> &write) {
+    std::lock_guard<std::mutex> apply(apply_mtx_);
+    flushLocked();
+
+    if (!cells.empty()) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        std::string records;
+        for (auto &[student_id, lesson_id] : cells) records += journalRecord(student_id, lesson_id, -1, false);
+        try {
+            uint64_t first = append(lock, records, cells.size()) - cells.size() + 1;
+            // Оценки, поставленные через очередь до отметки, перекрываются прямой записью
+            for (size_t i = 0; i < cells.size(); ++i) {
+                auto it = pending_.find(cellKey(cells[i].first, cells[i].second));
+                if (it != pending_.end() && it->second.seq < first + i) pending_.erase(it);
+            }
+            queued_ += cells.size();
+            if (queued_ == synced_) synced_cv_.notify_all();
+        } catch (const std::runtime_error &) {
+            // Журнал не пишется: старых строк по этим ячейкам в нём нет, если flushLocked()
+            // успел его переписать; иначе о повторе при старте предупредит лог checkpoint()
+        }
+    }
+    write();
+}
+
+std::vector<PendingGrade> GradeQueue::pending() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<PendingGrade> out;
+    out.reserve(pending_.size() + inflight_.size());
+    for (auto &[key, e] : pending_) out.push_back(e.grade);
+    for (auto &[key, e] : inflight_) {
+        if (!pending_.count(key)) out.push_back(e.grade);
+    }
+    return out;
+}
+
+size_t GradeQueue::size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return pending_.size() + inflight_.size();
+}
+
+void GradeQueue::flush() {
+    std::lock_guard<std::mutex> apply(apply_mtx_);
+    flushLocked();
+}
+
+// Забрать накопленное, применить одной транзакцией (Database::upsertGrades).
+// При ошибке БД ячейки возвращаются в очередь, если их не перекрыла более новая оценка
+void GradeQueue::flushLocked() {
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (pending_.empty()) {
+            // Применять нечего, но в журнале могут остаться отметки прямой записи
+            if (synced_ != checkpoint_seq_) checkpoint(lock);
+            return;
+        }
+        inflight_.swap(pending_);
+    }
+
+    std::vector<GradeWrite> writes;
+    writes.reserve(inflight_.size());
+    for (auto &[key, e] : inflight_) writes.push_back({e.grade.student_id, e.grade.lesson_id, gradeText(e.grade.score, e.grade.absent)});
+
+    try {
+        auto status = db_.upsertGrades(writes);
+        for (size_t i = 0; i < writes.size(); ++i) {
+            if (status[i] != "ok")
+                std::cerr << "[WARN] Grade queue: dropped grade for student " << writes[i].student_id
+                          << ", lesson " << writes[i].lesson_id << ": " << status[i] << std::endl;
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto &[key, e] : inflight_) pending_.emplace(key, e);
+        inflight_.clear();
+        throw;
+    }
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    inflight_.clear();
+    checkpoint(lock);
+}
+
+// Журнал заново: только то, что ещё ждёт в pending_, остальное уже в БД. Строки, которые
+// синхронизированы, но ещё не учтены в pending_, потерялись бы — дожидаемся их учёта.
+// Пока журнал переписывается (под mtx_), put() ждёт: он всё равно ждал бы fdatasync.
+// Непустой журнал пишется во временный файл и заменяет старый rename'ом: при сбое
+// на диске остаётся либо старый журнал, либо новый целиком
+void GradeQueue::checkpoint(std::unique_lock<std::mutex> &lock) {
+    if (!synced_cv_.wait_for(lock, options_.flush_interval, [this] { return !syncing_ && queued_ == synced_; }))
+        return; // перепишем после следующей записи в БД
+
+    std::string data;
+    for (auto &[key, e] : pending_) data += journalRecord(e.grade.student_id, e.grade.lesson_id, e.grade.score, e.grade.absent);
+
+    if (data.empty()) {
+        if (::ftruncate(fd_, 0) != 0) {
+            std::cerr << "[WARN] Grade journal truncate failed, old grades may be replayed on restart: "
+                      << std::strerror(errno) << std::endl;
+            return;
+        }
+        checkpoint_seq_ = synced_;
+        return;
+    }
+
+    std::string tmp = options_.journal_path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    bool ok = fd >= 0 && writeAll(fd, data) && ::fdatasync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), options_.journal_path.c_str()) != 0) {
+        std::cerr << "[WARN] Grade journal rewrite failed, old grades may be replayed on restart: "
+                  << std::strerror(errno) << std::endl;
+        ::unlink(tmp.c_str());
+        return;
+    }
+    int next = ::open(options_.journal_path.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+    if (next < 0) {
+        // Старый дескриптор смотрит на удалённый файл: дальше писать некуда
+        std::cerr << "[ERROR] Cannot reopen grade journal: " << std::strerror(errno) << std::endl;
+        broken_ = true;
+        return;
+    }
+    ::close(fd_);
+    fd_ = next;
+    checkpoint_seq_ = synced_;
+}
+
+void GradeQueue::flusher() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            flush_cv_.wait_for(lock, options_.flush_interval,
+                               [this] { return stopping_ || pending_.size() >= options_.flush_max; });
+            if (stopping_) return;
+            if (pending_.empty()) continue;
+        }
+        try {
+            flush();
+        } catch (const std::exception &e) {
+            std::cerr << "[ERROR] Grade queue flush failed, will retry: " << e.what() << std::endl;
+            std::this_thread::sleep_for(options_.flush_interval);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "db.h"
+
+// Отложенная запись оценок (write-behind, GRADE_WRITE_BEHIND=1).
+// put() подтверждает оценку, как только она записана в локальный журнал и синхронизирована
+// на диск; записи нескольких потоков синхронизирует один fdatasync (групповая запись).
+// В памяти повторные оценки в ту же ячейку (студент, занятие) схлопываются, а фоновый поток
+// раз в flush_interval или при flush_max ячейках применяет их к БД одной транзакцией.
+// После каждой успешной записи в БД журнал переписывается: в нём остаётся только то, что
+// ещё ждёт в очереди. При старте непримененные записи перечитываются из журнала и
+// применяются заново (upsert идемпотентен).
+class GradeQueue {
+public:
+    struct Options {
+        std::string journal_path = "grade_journal.log";
+        std::chrono::milliseconds flush_interval{50};
+        size_t flush_max = 500;
+    };
+
+    GradeQueue(Database &db, Options options);
+    ~GradeQueue(); // останавливает поток и пытается применить остаток
+
+    GradeQueue(const GradeQueue &) = delete;
+    GradeQueue &operator=(const GradeQueue &) = delete;
+
+    // Возвращается после fdatasync журнала. runtime_error, если журнал недоступен:
+    // тогда вызывающий пишет в БД напрямую
+    void put(int student_id, int lesson_id, int score, bool absent);
+
+    // Ещё не записанные в БД оценки (для read-your-writes в журнале преподавателя)
+    std::vector<PendingGrade> pending() const;
+    size_t size() const;
+
+    // Применить всё накопленное сейчас
+    void flush();
+
+    // Прямая запись ячеек в БД в обход очереди (пакет, стирание, запасной путь при сбое журнала).
+    // Сначала применяет очередь, затем пишет в журнал отметки "ячейка записана напрямую":
+    // при старте они отменяют более ранние записи журнала по этим ячейкам, и повтор
+    // не перезапишет новую оценку старой. write() выполняется, пока очередь не применяется
+    void writeDirect(const std::vector<std::pair<int, int>> &cells, const std::function<void()> &write);
+
+private:
+    struct Entry {
+        PendingGrade grade;
+        uint64_t seq; // порядок put(): в ячейке остаётся более поздняя оценка
+    };
+    using Cells = std::unordered_map<uint64_t, Entry>;
+
+    static uint64_t cellKey(int student_id, int lesson_id);
+    void replay();
+    // Дописать count записей журнала и дождаться fdatasync; seq последней из них
+    uint64_t append(std::unique_lock<std::mutex> &lock, const std::string &records, size_t count);
+    void flushLocked(); // под apply_mtx_
+    void checkpoint(std::unique_lock<std::mutex> &lock); // под mtx_
+    void flusher();
+
+    Database &db_;
+    Options options_;
+    int fd_ = -1;
+
+    mutable std::mutex mtx_;
+    std::condition_variable synced_cv_;
+    std::condition_variable flush_cv_;
+    Cells pending_;
+    Cells inflight_;       // взяты потоком записи, но ещё не подтверждены БД
+    std::string buffer_;   // записи журнала, ждущие записи на диск
+    uint64_t appended_ = 0, synced_ = 0;
+    uint64_t queued_ = 0;  // сколько записей журнала уже учтено в pending_ (переписать журнал можно, если все)
+    uint64_t checkpoint_seq_ = 0; // synced_ на момент последней перезаписи журнала
+    bool syncing_ = false; // кто-то из put() сейчас пишет буфер за всех
+    bool broken_ = false;  // журнал не пишется: очередь отключена
+    bool stopping_ = false;
+
+    std::mutex apply_mtx_; // одна транзакция применения за раз
+    std::thread thread_;
+};
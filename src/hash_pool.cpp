@@ -0,0 +1,81 @@
+#include "hash_pool.h"
+#include <iostream>
+
+HashPool::HashPool(size_t threads, size_t queue_limit)
+    : queue_limit_(queue_limit == 0 ? 1 : queue_limit) {
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back([this] { worker(); });
+    }
+}
+
+HashPool::~HashPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto &t : threads_) t.join();
+}
+
+bool HashPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (stopping_ || queue_.size() >= queue_limit_) {
+            ++rejected_;
+            return false;
+        }
+        queue_.push_back({std::move(job), Clock::now()});
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void HashPool::worker() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return; // stopping_ и задач больше нет
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        // Время ожидания в очереди
+        uint64_t wait_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - job.enqueued).count();
+        total_wait_us_ += wait_us;
+        ++started_;
+        uint64_t prev = max_wait_us_.load();
+        while (wait_us > prev && !max_wait_us_.compare_exchange_weak(prev, wait_us)) {}
+
+        ++running_;
+        try {
+            job.fn();
+        } catch (const std::exception &e) {
+            std::cerr << "[ERROR] Hash pool job failed: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "[ERROR] Hash pool job failed" << std::endl;
+        }
+        --running_;
+        ++completed_;
+    }
+}
+
+HashPool::Stats HashPool::stats() {
+    Stats s{};
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        s.queue_depth = queue_.size();
+    }
+    s.threads = threads_.size();
+    s.queue_limit = queue_limit_;
+    s.running = running_.load();
+    s.completed = completed_.load();
+    s.rejected = rejected_.load();
+    uint64_t started = started_.load();
+    s.avg_wait_ms = started ? total_wait_us_.load() / 1000.0 / started : 0.0;
+    s.max_wait_ms = max_wait_us_.load() / 1000.0;
+    return s;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Отдельный пул потоков для PBKDF2 (hashPassword / checkPassword).
+// Очередь ограничена: если она заполнена, submit() возвращает false,
+// и обработчик сразу отвечает 429 вместо того, чтобы занимать поток Crow.
+class HashPool {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        size_t threads;
+        size_t queue_depth;   // задач ждёт в очереди
+        size_t queue_limit;
+        size_t running;       // задач выполняется прямо сейчас
+        uint64_t completed;
+        uint64_t rejected;    // отклонено из-за полной очереди
+        double avg_wait_ms;   // среднее время ожидания в очереди
+        double max_wait_ms;
+    };
+
+    HashPool(size_t threads, size_t queue_limit);
+    ~HashPool();
+
+    HashPool(const HashPool &) = delete;
+    HashPool &operator=(const HashPool &) = delete;
+
+    // Поставить задачу в очередь; false — очередь заполнена
+    bool submit(std::function<void()> job);
+
+    Stats stats();
+
+private:
+    struct Job {
+        std::function<void()> fn;
+        Clock::time_point enqueued;
+    };
+
+    void worker();
+
+    size_t queue_limit_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<Job> queue_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+
+    std::atomic<size_t> running_{0};
+    std::atomic<uint64_t> started_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> total_wait_us_{0};
+    std::atomic<uint64_t> max_wait_us_{0};
+};
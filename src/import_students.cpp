@@ -0,0 +1,52 @@
+// Консольный импорт студентов из CSV (миграции и запросы встроены, каталог запуска любой):
+//   ./import_students students.csv ["dbname=students_db user=admin password=admin host=db"]
+// Формат: login,password,first_name,last_name,dob,group
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include "student_import.h"
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <file.csv> [connection string]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(argv[1]);
+    if (!file.is_open()) {
+        std::cerr << "ERROR: cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    std::string conn_str = argc > 2 ? argv[2] : "dbname=students_db user=admin password=admin host=db";
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    try {
+        Database db(conn_str, 1);
+
+        // Прогресс в одну строку: этап, сделано/всего, время
+        auto progress = [&](const std::string &stage, size_t done, size_t total) {
+            std::cerr << "\r[" << stage << "] " << done << "/" << total
+                      << "  " << static_cast<int>(elapsed()) << "s   " << std::flush;
+            if (done == total) std::cerr << std::endl;
+        };
+
+        auto result = importStudentsCsv(db, file, progress);
+
+        for (auto &e : result.errors) std::cerr << "WARN: " << e << std::endl;
+        std::cout << "rows:               " << result.rows << "\n"
+                  << "inserted:           " << result.inserted << "\n"
+                  << "skipped (existing): " << result.skipped_existing << "\n"
+                  << "duplicates in file: " << result.duplicates_in_file << "\n"
+                  << "without group:      " << result.without_group << "\n"
+                  << "errors:             " << result.errors.size() << "\n"
+                  << "time:               " << elapsed() << "s" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
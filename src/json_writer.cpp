@@ -0,0 +1,131 @@
+#include "json_writer.h"
+#include <cmath>
+
+// Запятая перед очередным элементом массива или ключом объекта
+void JsonWriter::separate() {
+    if (need_comma_) buf_ += ',';
+}
+
+JsonWriter &JsonWriter::beginObject() {
+    separate();
+    buf_ += '{';
+    need_comma_ = false;
+    return *this;
+}
+
+JsonWriter &JsonWriter::endObject() {
+    buf_ += '}';
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::beginArray() {
+    separate();
+    buf_ += '[';
+    need_comma_ = false;
+    return *this;
+}
+
+JsonWriter &JsonWriter::endArray() {
+    buf_ += ']';
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::key(std::string_view name) {
+    separate();
+    escape(name);
+    buf_ += ':';
+    need_comma_ = false;
+    return *this;
+}
+
+// Строка в кавычках; непечатные символы и " \ экранируются, UTF-8 проходит как есть.
+// Участки без спецсимволов копируются целиком.
+void JsonWriter::escape(std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    buf_ += '"';
+    size_t start = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        buf_.append(s.data() + start, i - start);
+        start = i + 1;
+        switch (c) {
+            case '"':  buf_ += "\\\""; break;
+            case '\\': buf_ += "\\\\"; break;
+            case '\n': buf_ += "\\n"; break;
+            case '\r': buf_ += "\\r"; break;
+            case '\t': buf_ += "\\t"; break;
+            case '\b': buf_ += "\\b"; break;
+            case '\f': buf_ += "\\f"; break;
+            default:
+                buf_ += "\\u00";
+                buf_ += hex[c >> 4];
+                buf_ += hex[c & 0xf];
+        }
+    }
+    buf_.append(s.data() + start, s.size() - start);
+    buf_ += '"';
+}
+
+JsonWriter &JsonWriter::string(std::string_view s) {
+    separate();
+    escape(s);
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::number(double v) {
+    if (!std::isfinite(v)) return null(); // в JSON нет NaN/Inf
+    separate();
+    char tmp[32];
+    auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+    buf_.append(tmp, r.ptr);
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::boolean(bool v) {
+    return raw(v ? "true" : "false");
+}
+
+JsonWriter &JsonWriter::null() {
+    return raw("null");
+}
+
+JsonWriter &JsonWriter::raw(std::string_view json) {
+    separate();
+    buf_.append(json);
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter &JsonWriter::string(const pqxx::field &f) {
+    if (f.is_null()) return null();
+    return string(std::string_view(f.c_str(), f.size()));
+}
+
+JsonWriter &JsonWriter::string(const pqxx::field &f, std::string_view if_null) {
+    return string(f.is_null() ? if_null : std::string_view(f.c_str(), f.size()));
+}
+
+// Текстовое представление integer/numeric из PostgreSQL уже является JSON-числом
+JsonWriter &JsonWriter::number(const pqxx::field &f) {
+    if (f.is_null()) return null();
+    return raw(std::string_view(f.c_str(), f.size()));
+}
+
+JsonWriter &JsonWriter::number(const pqxx::field &f, std::string_view if_null) {
+    return raw(f.is_null() ? if_null : std::string_view(f.c_str(), f.size()));
+}
+
+crow::response JsonWriter::response(int code) {
+    crow::response res(code);
+    res.body = take();
+    res.set_header("Content-Type", "application/json");
+    buf_.clear();
+    need_comma_ = false;
+    return res;
+}
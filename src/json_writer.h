@@ -0,0 +1,66 @@
+#pragma once
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <pqxx/pqxx>
+#include <crow.h>
+
+// Потоковая запись JSON в один буфер, без промежуточного дерева wvalue.
+// Только вперёд: beginObject/key/value/.../endObject. Запятые расставляются сами.
+//
+//   JsonWriter w;
+//   w.beginArray();
+//   for (auto row : r) {
+//       w.beginObject();
+//       w.key("id").number(row["id"]);
+//       w.key("login").string(row["login"]);
+//       w.endObject();
+//   }
+//   w.endArray();
+//   return w.response();
+class JsonWriter {
+public:
+    explicit JsonWriter(size_t reserve = 4096) { buf_.reserve(reserve); }
+
+    JsonWriter &beginObject();
+    JsonWriter &endObject();
+    JsonWriter &beginArray();
+    JsonWriter &endArray();
+    JsonWriter &key(std::string_view name);
+
+    JsonWriter &string(std::string_view s);
+    template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    JsonWriter &number(T v) {
+        separate();
+        char tmp[24];
+        auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        buf_.append(tmp, r.ptr);
+        need_comma_ = true;
+        return *this;
+    }
+    JsonWriter &number(double v);
+    JsonWriter &boolean(bool v);
+    JsonWriter &null();
+    // Готовый JSON-фрагмент (например, числовой текст из БД) — без проверки
+    JsonWriter &raw(std::string_view json);
+
+    // Поля pqxx пишутся прямо из буфера результата, без std::string
+    JsonWriter &string(const pqxx::field &f);                          // NULL -> null
+    JsonWriter &string(const pqxx::field &f, std::string_view if_null);
+    JsonWriter &number(const pqxx::field &f);                          // NULL -> null
+    JsonWriter &number(const pqxx::field &f, std::string_view if_null);
+
+    const std::string &str() const { return buf_; }
+    std::string take() { return std::move(buf_); }
+
+    // Ответ с Content-Type: application/json; буфер переносится в тело
+    crow::response response(int code = 200);
+
+private:
+    void separate();
+    void escape(std::string_view s);
+
+    std::string buf_;
+    bool need_comma_ = false;
+};
@@ -0,0 +1,523 @@
+// Нагрузочный генератор: сценарии как у student.js и teacher.js с открытой моделью прихода.
+//   ./loadgen [--host 127.0.0.1] [--port 18080] [--rate 200] [--duration 60] [--warmup 5]
+//             [--mix student=80,teacher=15,login=5] [--workers 256] [--students 500] [--teachers 50]
+//             [--seed 1] [--password password] [--grades-per-journal 5] [--json report.json]
+// Пользователи — из gen_dataset (логины s<seed>_<n>, t<seed>_<n>): сначала все --students
+// и --teachers входят одновременно, затем сценарии приходят пуассоновским потоком с
+// частотой --rate в секунду, независимо от того, успевает ли сервер (open loop).
+//
+//   student: профиль, оценки, по запросу predict на каждый предмет из оценок, группа
+//   teacher: предметы -> группы предмета -> журнал -> --grades-per-journal POST /teacher/grade
+//   login:   повторный вход случайного студента (PBKDF2 на сервере)
+//
+// Задержка первого запроса сценария считается от запланированного времени прихода, а не от
+// момента, когда освободился рабочий поток: при насыщении очередь видна в p99 (без
+// coordinated omission). Итог — пропускная способность и p50/p99/p999 по маршрутам.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <crow.h>
+#include "json_writer.h"
+#include "metrics.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 18080;
+    double rate = 200;       // сценариев в секунду
+    double duration = 60;    // секунд измерения
+    double warmup = 5;       // секунд до начала учёта
+    int workers = 256;
+    int students = 500;      // сессий студентов
+    int teachers = 50;       // сессий преподавателей
+    uint64_t seed = 1;
+    std::string password = "password";
+    int grades_per_journal = 5;
+    double mix[3] = {80, 15, 5}; // student, teacher, login
+    std::string json;
+};
+
+// ----------------- Маршруты и статистика -----------------
+
+enum Route { LOGIN, PROFILE, GRADES, PREDICT, GROUP, T_COURSES, T_GROUPS, T_JOURNAL, T_GRADE, ROUTES };
+
+static const char *const ROUTE_NAMES[ROUTES] = {
+    "POST /login",
+    "GET /students/<id>/profile",
+    "GET /students/<id>/grades",
+    "GET /students/<id>/predict",
+    "GET /students/<id>/group",
+    "GET /teacher/courses",
+    "GET /teacher/courses/<id>/groups",
+    "GET /teacher/journal",
+    "POST /teacher/grade",
+};
+
+// Своя на рабочий поток, складываются в конце
+struct Stats {
+    struct PerRoute {
+        uint64_t ok = 0, errors = 0;
+        std::vector<uint64_t> buckets = std::vector<uint64_t>(LatencyBuckets::COUNT);
+    };
+    PerRoute routes[ROUTES];
+    std::vector<uint64_t> start_lag = std::vector<uint64_t>(LatencyBuckets::COUNT); // приход -> начало сценария
+    uint64_t scenarios = 0;
+
+    void merge(const Stats &other) {
+        for (int r = 0; r < ROUTES; ++r) {
+            routes[r].ok += other.routes[r].ok;
+            routes[r].errors += other.routes[r].errors;
+            for (int i = 0; i < LatencyBuckets::COUNT; ++i) routes[r].buckets[i] += other.routes[r].buckets[i];
+        }
+        for (int i = 0; i < LatencyBuckets::COUNT; ++i) start_lag[i] += other.start_lag[i];
+        scenarios += other.scenarios;
+    }
+};
+
+static double quantileMs(const std::vector<uint64_t> &buckets, double q) {
+    uint64_t total = 0;
+    for (auto n : buckets) total += n;
+    if (!total) return 0;
+    auto rank = static_cast<uint64_t>(std::ceil(q * total));
+    uint64_t cumulative = 0;
+    int b = 0;
+    for (; b < LatencyBuckets::COUNT - 1; ++b) {
+        cumulative += buckets[b];
+        if (cumulative >= rank) break;
+    }
+    return LatencyBuckets::upperBound(b) / 1000.0;
+}
+
+// ----------------- HTTP/1.1 с keep-alive -----------------
+
+struct HttpResponse {
+    int status = 0; // 0 — ошибка сети
+    std::string body;
+};
+
+class HttpClient {
+public:
+    HttpClient(const std::string &host, int port) : host_(host), port_(port) {}
+    ~HttpClient() { close(); }
+
+    HttpClient(const HttpClient &) = delete;
+    HttpClient &operator=(const HttpClient &) = delete;
+
+    // При обрыве keep-alive соединения запрос повторяется один раз на новом
+    HttpResponse request(const char *method, const std::string &path, const std::string &token, const std::string &body = {}) {
+        std::string req = std::string(method) + ' ' + path + " HTTP/1.1\r\nHost: " + host_ + "\r\nConnection: keep-alive\r\n";
+        if (!token.empty()) req += "Authorization: Bearer " + token + "\r\n";
+        if (!body.empty()) req += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+        req += "\r\n" + body;
+
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            if (fd_ < 0 && !connect()) return {};
+            HttpResponse res;
+            if (sendAll(req) && readResponse(res)) return res;
+            close();
+        }
+        return {};
+    }
+
+private:
+    bool connect() {
+        addrinfo hints{}, *ai = nullptr;
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &ai) != 0) return false;
+        fd_ = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        bool ok = fd_ >= 0 && ::connect(fd_, ai->ai_addr, ai->ai_addrlen) == 0;
+        freeaddrinfo(ai);
+        if (!ok) {
+            close();
+            return false;
+        }
+        int one = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        buf_.clear();
+        return true;
+    }
+
+    void close() {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+    }
+
+    bool sendAll(const std::string &data) {
+        for (size_t off = 0; off < data.size();) {
+            ssize_t n = send(fd_, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            off += n;
+        }
+        return true;
+    }
+
+    bool fill() {
+        char chunk[16384];
+        ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buf_.append(chunk, n);
+        return true;
+    }
+
+    // Заголовки до пустой строки, тело по Content-Length (Crow отвечает без chunked)
+    bool readResponse(HttpResponse &res) {
+        size_t end;
+        while ((end = buf_.find("\r\n\r\n")) == std::string::npos)
+            if (!fill()) return false;
+
+        std::string head = buf_.substr(0, end);
+        if (head.compare(0, 5, "HTTP/") != 0 || head.size() < 12) return false;
+        res.status = std::atoi(head.c_str() + 9);
+
+        size_t length = 0;
+        bool close_after = false;
+        std::string lower = head;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        if (size_t p = lower.find("\r\ncontent-length:"); p != std::string::npos) length = std::strtoul(lower.c_str() + p + 17, nullptr, 10);
+        if (lower.find("\r\nconnection: close") != std::string::npos) close_after = true;
+
+        while (buf_.size() < end + 4 + length)
+            if (!fill()) return false;
+        res.body = buf_.substr(end + 4, length);
+        buf_.erase(0, end + 4 + length);
+        if (close_after) close();
+        return true;
+    }
+
+    std::string host_;
+    int port_;
+    int fd_ = -1;
+    std::string buf_;
+};
+
+// ----------------- Сессии и сценарии -----------------
+
+struct Session {
+    std::string login;
+    std::string token;
+    int student_id = 0; // для студентов
+};
+
+enum Scenario { STUDENT, TEACHER, RELOGIN };
+
+struct Arrival {
+    Clock::time_point due;
+    Scenario scenario;
+};
+
+class Worker {
+public:
+    Worker(const Options &o, const std::vector<Session> &students, const std::vector<Session> &teachers, uint64_t seed)
+        : o_(o), students_(students), teachers_(teachers), http_(o.host, o.port), rng_(seed) {}
+
+    // recording = false во время прогрева
+    void run(const Arrival &a, bool recording) {
+        recording_ = recording;
+        next_due_ = a.due;
+        if (recording_) {
+            ++stats.scenarios;
+            auto lag = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - a.due).count();
+            ++stats.start_lag[LatencyBuckets::index(std::max<int64_t>(lag, 0))];
+        }
+        switch (a.scenario) {
+        case STUDENT: student(); break;
+        case TEACHER: teacher(); break;
+        case RELOGIN: relogin(); break;
+        }
+    }
+
+    // Вход перед прогоном; false — не удалось
+    bool login(Session &s, bool student) {
+        std::string body = "{\"login\":\"" + s.login + "\",\"password\":\"" + o_.password + "\"}";
+        auto res = http_.request("POST", "/login", "", body);
+        auto json = crow::json::load(res.body);
+        if (res.status != 200 || !json || !json.has("token")) return false;
+        s.token = json["token"].s();
+        if (student) s.student_id = static_cast<int>(json["studentId"].i());
+        return true;
+    }
+
+    Stats stats;
+
+private:
+    // Запрос с учётом в статистике; первый запрос сценария отсчитывается от времени прихода
+    HttpResponse call(Route route, const char *method, const std::string &path, const std::string &token, const std::string &body = {}) {
+        auto start = Clock::now();
+        auto from = std::min(start, next_due_);
+        next_due_ = Clock::time_point::max();
+        auto res = http_.request(method, path, token, body);
+        if (recording_) {
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - from).count();
+            auto &r = stats.routes[route];
+            ++r.buckets[LatencyBuckets::index(us)];
+            if (res.status >= 200 && res.status < 300) ++r.ok;
+            else ++r.errors;
+        }
+        return res;
+    }
+
+    template <typename T>
+    const T &pick(const std::vector<T> &items) {
+        return items[std::uniform_int_distribution<size_t>(0, items.size() - 1)(rng_)];
+    }
+
+    // student.js: профиль, оценки с прогнозом по каждому предмету, одногруппники
+    void student() {
+        if (students_.empty()) return;
+        const Session &s = pick(students_);
+        std::string base = "/students/" + std::to_string(s.student_id);
+        call(PROFILE, "GET", base + "/profile", s.token);
+
+        auto res = call(GRADES, "GET", base + "/grades", s.token);
+        std::vector<int64_t> courses;
+        if (auto grades = crow::json::load(res.body); grades && grades.t() == crow::json::type::List) {
+            for (auto &g : grades)
+                if (g.has("course_id")) courses.push_back(g["course_id"].i());
+        }
+        std::sort(courses.begin(), courses.end());
+        courses.erase(std::unique(courses.begin(), courses.end()), courses.end());
+        for (auto c : courses) call(PREDICT, "GET", base + "/predict?course_id=" + std::to_string(c), s.token);
+
+        call(GROUP, "GET", base + "/group", s.token);
+    }
+
+    // teacher.js: предмет -> группа -> журнал -> правки ячеек
+    void teacher() {
+        if (teachers_.empty()) return;
+        const Session &t = pick(teachers_);
+        auto courses = crow::json::load(call(T_COURSES, "GET", "/teacher/courses", t.token).body);
+        if (!courses || courses.t() != crow::json::type::List || courses.size() == 0) return;
+        int64_t course = courses[std::uniform_int_distribution<size_t>(0, courses.size() - 1)(rng_)]["id"].i();
+
+        auto groups = crow::json::load(call(T_GROUPS, "GET", "/teacher/courses/" + std::to_string(course) + "/groups", t.token).body);
+        if (!groups || groups.t() != crow::json::type::List || groups.size() == 0) return;
+        int64_t group = groups[std::uniform_int_distribution<size_t>(0, groups.size() - 1)(rng_)]["id"].i();
+
+        auto journal = crow::json::load(call(T_JOURNAL, "GET", "/teacher/journal?course_id=" + std::to_string(course) +
+                                                                   "&group_id=" + std::to_string(group), t.token).body);
+        if (!journal || !journal.has("lessons") || !journal.has("students")) return;
+        auto &lessons = journal["lessons"];
+        auto &students = journal["students"];
+        if (lessons.size() == 0 || students.size() == 0) return;
+
+        static const char *const GRADES[] = {"2", "3", "4", "5", "5", "4", "Н"};
+        for (int i = 0; i < o_.grades_per_journal; ++i) {
+            int64_t lesson = lessons[std::uniform_int_distribution<size_t>(0, lessons.size() - 1)(rng_)]["id"].i();
+            int64_t student = students[std::uniform_int_distribution<size_t>(0, students.size() - 1)(rng_)]["id"].i();
+            const char *grade = GRADES[std::uniform_int_distribution<size_t>(0, std::size(GRADES) - 1)(rng_)];
+            std::string body = "{\"student_id\":" + std::to_string(student) + ",\"lesson_id\":" + std::to_string(lesson) +
+                               ",\"grade\":\"" + grade + "\"}";
+            call(T_GRADE, "POST", "/teacher/grade", t.token, body);
+        }
+    }
+
+    void relogin() {
+        if (students_.empty()) return;
+        const Session &s = pick(students_);
+        call(LOGIN, "POST", "/login", "", "{\"login\":\"" + s.login + "\",\"password\":\"" + o_.password + "\"}");
+    }
+
+    const Options &o_;
+    const std::vector<Session> &students_;
+    const std::vector<Session> &teachers_;
+    HttpClient http_;
+    std::mt19937_64 rng_;
+    bool recording_ = false;
+    Clock::time_point next_due_;
+};
+
+// ----------------- Прогон -----------------
+
+static bool parseArgs(int argc, char **argv, Options &o) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+        if (arg == "--host") o.host = value;
+        else if (arg == "--port") o.port = std::atoi(value.c_str());
+        else if (arg == "--rate") o.rate = std::atof(value.c_str());
+        else if (arg == "--duration") o.duration = std::atof(value.c_str());
+        else if (arg == "--warmup") o.warmup = std::atof(value.c_str());
+        else if (arg == "--workers") o.workers = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--students") o.students = std::atoi(value.c_str());
+        else if (arg == "--teachers") o.teachers = std::atoi(value.c_str());
+        else if (arg == "--seed") o.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--password") o.password = value;
+        else if (arg == "--grades-per-journal") o.grades_per_journal = std::atoi(value.c_str());
+        else if (arg == "--json") o.json = value;
+        else if (arg == "--mix") {
+            // student=80,teacher=15,login=5
+            std::stringstream ss(value);
+            for (std::string part; std::getline(ss, part, ',');) {
+                auto eq = part.find('=');
+                if (eq == std::string::npos) return false;
+                std::string name = part.substr(0, eq);
+                double w = std::atof(part.c_str() + eq + 1);
+                if (name == "student") o.mix[STUDENT] = w;
+                else if (name == "teacher") o.mix[TEACHER] = w;
+                else if (name == "login") o.mix[RELOGIN] = w;
+                else return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && o.rate > 0 && o.duration > 0;
+}
+
+// Вход всех сессий сразу: по потоку на рабочего, сессии между ними по кругу
+static std::vector<Session> loginAll(const Options &o, std::deque<Worker> &workers, char prefix, int count, bool student) {
+    std::vector<Session> sessions(count);
+    for (int i = 0; i < count; ++i) sessions[i].login = prefix + std::to_string(o.seed) + "_" + std::to_string(i + 1);
+    std::vector<char> ok(count, 0);
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workers.size(); ++w) {
+        threads.emplace_back([&, w] {
+            for (size_t i = w; i < sessions.size(); i += workers.size()) ok[i] = workers[w].login(sessions[i], student);
+        });
+    }
+    for (auto &t : threads) t.join();
+
+    std::vector<Session> result;
+    for (int i = 0; i < count; ++i)
+        if (ok[i]) result.push_back(sessions[i]);
+    if (static_cast<int>(result.size()) < count)
+        std::cerr << "[WARN] " << count - result.size() << " of " << count << " " << (student ? "student" : "teacher")
+                  << " logins failed (run gen_dataset with the same --seed?)" << std::endl;
+    return result;
+}
+
+static void report(const Options &o, const Stats &total, double seconds, uint64_t arrivals) {
+    std::cout << "rate " << o.rate << "/s, measured " << seconds << " s, scenarios " << total.scenarios << " of " << arrivals
+              << " arrived, start lag p99 " << quantileMs(total.start_lag, 0.99) << " ms\n\n";
+    std::cout << std::left << std::setw(34) << "route" << std::right << std::setw(10) << "req/s" << std::setw(9) << "errors"
+              << std::setw(11) << "p50 ms" << std::setw(11) << "p99 ms" << std::setw(11) << "p999 ms" << "\n";
+    for (int r = 0; r < ROUTES; ++r) {
+        auto &s = total.routes[r];
+        if (!s.ok && !s.errors) continue;
+        std::cout << std::left << std::setw(34) << ROUTE_NAMES[r] << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << (s.ok + s.errors) / seconds << std::setw(9) << s.errors << std::setprecision(2)
+                  << std::setw(11) << quantileMs(s.buckets, 0.5) << std::setw(11) << quantileMs(s.buckets, 0.99)
+                  << std::setw(11) << quantileMs(s.buckets, 0.999) << "\n";
+    }
+    std::cout << std::flush;
+
+    if (o.json.empty()) return;
+    JsonWriter out;
+    out.beginObject();
+    out.key("rate").number(o.rate);
+    out.key("seconds").number(seconds);
+    out.key("arrivals").number(arrivals);
+    out.key("scenarios").number(total.scenarios);
+    out.key("start_lag_p99_ms").number(quantileMs(total.start_lag, 0.99));
+    out.key("routes").beginArray();
+    for (int r = 0; r < ROUTES; ++r) {
+        auto &s = total.routes[r];
+        if (!s.ok && !s.errors) continue;
+        out.beginObject();
+        out.key("route").string(ROUTE_NAMES[r]);
+        out.key("requests").number(s.ok + s.errors);
+        out.key("errors").number(s.errors);
+        out.key("throughput").number((s.ok + s.errors) / seconds);
+        out.key("p50_ms").number(quantileMs(s.buckets, 0.5));
+        out.key("p99_ms").number(quantileMs(s.buckets, 0.99));
+        out.key("p999_ms").number(quantileMs(s.buckets, 0.999));
+        out.endObject();
+    }
+    out.endArray();
+    out.endObject();
+    std::ofstream(o.json) << out.take() << std::endl;
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!parseArgs(argc, argv, o)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--host H] [--port P] [--rate R] [--duration S] [--warmup S] [--mix student=80,teacher=15,login=5]"
+                     " [--workers N] [--students N] [--teachers N] [--seed S] [--password P] [--grades-per-journal N] [--json FILE]"
+                  << std::endl;
+        return 2;
+    }
+
+    std::vector<Session> students, teachers;
+    std::deque<Worker> workers; // HttpClient не перемещается
+    for (int i = 0; i < o.workers; ++i) workers.emplace_back(o, students, teachers, o.seed * 1000003 + i);
+
+    auto login_start = Clock::now();
+    students = loginAll(o, workers, 's', o.students, true);
+    teachers = loginAll(o, workers, 't', o.teachers, false);
+    std::cerr << "[INFO] Logged in " << students.size() << " students and " << teachers.size() << " teachers in "
+              << std::chrono::duration<double>(Clock::now() - login_start).count() << " s" << std::endl;
+    if (students.empty() && teachers.empty()) return 1;
+
+    // Очередь приходов: планировщик кладёт по расписанию, свободные рабочие забирают
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Arrival> queue;
+    bool done = false;
+    const auto begin = Clock::now();
+    const auto measure_from = begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(o.warmup));
+    const auto end = measure_from + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(o.duration));
+
+    std::vector<std::thread> threads;
+    for (auto &w : workers) {
+        threads.emplace_back([&, wp = &w] {
+            for (;;) {
+                Arrival a;
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    cv.wait(lock, [&] { return done || !queue.empty(); });
+                    if (queue.empty()) return;
+                    a = queue.front();
+                    queue.pop_front();
+                }
+                wp->run(a, a.due >= measure_from && a.due < end);
+            }
+        });
+    }
+
+    // Пуассоновский поток: интервалы ~ Exp(rate), сценарий — по весам --mix
+    std::mt19937_64 rng(o.seed);
+    std::exponential_distribution<double> gap(o.rate);
+    std::discrete_distribution<int> kind({o.mix[STUDENT], o.mix[TEACHER], o.mix[RELOGIN]});
+    uint64_t arrivals = 0;
+    for (auto due = begin; due < end;) {
+        std::this_thread::sleep_until(due);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            queue.push_back({due, static_cast<Scenario>(kind(rng))});
+        }
+        cv.notify_one();
+        if (due >= measure_from) ++arrivals;
+        due += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap(rng)));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        done = true;
+    }
+    cv.notify_all();
+    for (auto &t : threads) t.join();
+
+    Stats total;
+    for (auto &w : workers) total.merge(w.stats);
+    report(o, total, o.duration, arrivals);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+// Потокобезопасный LRU фиксированной ёмкости: get/put/erase за O(1).
+//
+// Чтобы не вернуть в кеш устаревшую строку, прочитанную из БД параллельно с изменением,
+// put() принимает эпоху, снятую до чтения (epoch()). Любой erase/clear увеличивает эпоху,
+// и запоздавший put с прежней эпохой игнорируется.
+template <typename Key, typename Value>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+    uint64_t epoch() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return epoch_;
+    }
+
+    std::optional<Value> get(const Key &key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) return std::nullopt;
+        items_.splice(items_.begin(), items_, it->second); // в начало — самый свежий
+        return it->second->second;
+    }
+
+    void put(const Key &key, Value value, uint64_t read_epoch) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (read_epoch != epoch_ || capacity_ == 0) return;
+
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            it->second->second = std::move(value);
+            items_.splice(items_.begin(), items_, it->second);
+            return;
+        }
+        items_.emplace_front(key, std::move(value));
+        index_[key] = items_.begin();
+        if (items_.size() > capacity_) {
+            index_.erase(items_.back().first);
+            items_.pop_back();
+        }
+    }
+
+    void erase(const Key &key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++epoch_;
+        auto it = index_.find(key);
+        if (it == index_.end()) return;
+        items_.erase(it->second);
+        index_.erase(it);
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++epoch_;
+        items_.clear();
+        index_.clear();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+private:
+    using Item = std::pair<Key, Value>;
+
+    size_t capacity_;
+    uint64_t epoch_ = 0;
+    std::list<Item> items_; // от свежих к старым
+    std::unordered_map<Key, typename std::list<Item>::iterator> index_;
+    mutable std::mutex mutex_;
+};
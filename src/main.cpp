@@ -2,147 +2,385 @@
 #include "db.h"
 #include "crypto.h"
 #include "auth.h"
+#include "hash_pool.h"
+#include "student_import.h"
+#include "static_cache.h"
+#include "reference_data.h"
+#include "session_store.h"
+#include "async_db.h"
+#include "grade_queue.h"
+#include "metrics.h"
+#include "query_stats.h"
+#include "queries.h"
+#include <cstdlib>
+#include <memory>
+#include <type_traits>
+#include <unordered_set>
+
+// Ответить сразу (для ранних выходов в асинхронных обработчиках)
+void respond(crow::response &res, crow::response out) {
+    res = std::move(out);
+    res.end();
+}
 
-// ----------------- Статика -----------------
-crow::response serveFile(const std::string &filename) {
-    std::ifstream ifs("../web/" + filename, std::ios::binary);
-    if (!ifs) return crow::response(404);
+Task<void> finishAsync(crow::response &res, Task<crow::response> work);
+
+// ----------------- Пул хеширования -----------------
+// PBKDF2 выполняется в HashPool, а ответ отправляется из IO-потока соединения.
+// Если очередь пула заполнена — сразу 429, поток Crow не блокируется.
+// job может вернуть Task<crow::response>: тогда задача (обычно запись через AsyncDatabase)
+// запускается уже в IO-потоке соединения.
+template <typename Job>
+void offloadHashing(HashPool &pool, const crow::request &req, crow::response &res, Job job) {
+    auto *io = req.io_context;
+    bool queued = pool.submit([io, &res, job]() mutable {
+        if constexpr (std::is_same_v<decltype(job()), Task<crow::response>>) {
+            std::shared_ptr<Task<crow::response>> task;
+            try {
+                task = std::make_shared<Task<crow::response>>(job());
+            } catch (const std::exception &e) {
+                asio::post(*io, [&res, error = std::string(e.what())]() {
+                    respond(res, crow::response(500, crow::json::wvalue({{"error", error}})));
+                });
+                return;
+            }
+            asio::post(*io, [&res, task]() { spawn(finishAsync(res, std::move(*task))); });
+        } else {
+            auto out = std::make_shared<crow::response>();
+            try {
+                *out = job();
+            } catch (const std::exception &e) {
+                *out = crow::response(500, crow::json::wvalue({{"error", e.what()}}));
+            }
+            asio::post(*io, [&res, out]() {
+                res = std::move(*out);
+                res.end();
+            });
+        }
+    });
 
-    std::stringstream ss;
-    ss << ifs.rdbuf();
+    if (!queued) {
+        res = crow::response(429, crow::json::wvalue({{"error", "Сервер перегружен, повторите попытку позже"}}));
+        res.set_header("Retry-After", "1");
+        res.end();
+    }
+}
 
-    crow::response res(ss.str());
+// ?after_id=&limit= — keyset-пагинация списков. Без параметров список отдаётся целиком, как раньше.
+const int MAX_PAGE_LIMIT = 500;
+
+bool pageFromQuery(const crow::request &req, PageRequest &page) {
+    const char *after = req.url_params.get("after_id");
+    const char *limit = req.url_params.get("limit");
+    if (!after && !limit) return false;
+    if (after) page.after_id = std::max(0L, std::strtol(after, nullptr, 10));
+    if (limit) {
+        long n = std::strtol(limit, nullptr, 10);
+        if (n > 0) page.limit = static_cast<int>(std::min<long>(n, MAX_PAGE_LIMIT));
+    }
+    return true;
+}
 
-    // Заголовок Content-Type
-    if (filename.size() >= 5 && filename.substr(filename.size() - 5) == ".html")
-        res.set_header("Content-Type", "text/html");
-    else if (filename.size() >= 3 && filename.substr(filename.size() - 3) == ".js")
-        res.set_header("Content-Type", "application/javascript");
-    else if (filename.size() >= 4 && filename.substr(filename.size() - 4) == ".css")
-        res.set_header("Content-Type", "text/css");
+// MetricsMiddleware первым: его after_handle видит окончательный ответ
+using App = crow::App<MetricsMiddleware, SessionMiddleware>;
 
-    return res;
+// Сессия запроса (заполняет SessionMiddleware по токену из /login)
+const SessionMiddleware::context &session(App &app, const crow::request &req) {
+    return app.get_context<SessionMiddleware>(req);
 }
 
-int main() {
-    crow::SimpleApp app;
-    Database db("dbname=students_db user=admin password=admin host=db");
-    // HTML
-    CROW_ROUTE(app, "/")([](){ return serveFile("index.html"); });
-    CROW_ROUTE(app, "/admin.html")([](){ return serveFile("admin.html"); });
-    CROW_ROUTE(app, "/student.html")([](){ return serveFile("student.html"); });
-    CROW_ROUTE(app, "/teacher.html")([](){ return serveFile("teacher.html"); });
+// ----------------- Корутины -----------------
+// Обработчик запускает корутину через spawn(finishAsync(res, ...)) и сразу возвращается.
+// Корутина продолжается на io_context соединения по готовности сокета PostgreSQL,
+// а поток Crow тем временем обслуживает другие запросы.
+Task<void> finishAsync(crow::response &res, Task<crow::response> work) {
+    try {
+        res = co_await work;
+    } catch (const std::exception &e) {
+        res = crow::response(500, crow::json::wvalue({{"error", e.what()}}));
+    }
+    res.end();
+}
+
+Task<crow::response> journalResponse(AsyncDatabase &adb, asio::io_context &io, int course_id, int group_id,
+                                     std::vector<PendingGrade> pending) {
+    JsonWriter out(16 * 1024);
+    co_await adb.writeJournal(io, course_id, group_id, out, std::move(pending));
+    co_return out.response();
+}
+
+Task<crow::response> studentGradesResponse(AsyncDatabase &adb, asio::io_context &io, int student_id) {
+    JsonWriter out;
+    co_await adb.writeStudentGrades(io, student_id, out);
+    co_return out.response();
+}
 
-    // JS
-    CROW_ROUTE(app, "/js/api.js")([](){ return serveFile("js/api.js"); });
-    CROW_ROUTE(app, "/js/login.js")([](){ return serveFile("js/login.js"); });
-    CROW_ROUTE(app, "/js/admin.js")([](){ return serveFile("js/admin.js"); });
-    CROW_ROUTE(app, "/js/student.js")([](){ return serveFile("js/student.js"); });
-    CROW_ROUTE(app, "/js/teacher.js")([](){ return serveFile("js/teacher.js"); });
+Task<crow::response> groupMembersResponse(AsyncDatabase &adb, asio::io_context &io, int student_id) {
+    auto rating = co_await adb.getGroupRating(io, student_id);
+    JsonWriter out(64 + rating.size() * 80);
+    out.beginArray();
+    for (auto &st : rating) {
+        out.beginObject();
+        out.key("first_name").string(st.first_name);
+        out.key("last_name").string(st.last_name);
+        out.key("average_grade").number(st.avg_grade);
+        out.endObject();
+    }
+    out.endArray();
+    co_return out.response();
+}
 
+// Оценки из очереди отложенной записи поверх журнала группы (read-your-writes)
+void applyPendingGrades(GroupGradeSheet &sheet, const std::vector<PendingGrade> &pending) {
+    if (pending.empty()) return;
+    std::unordered_map<int, const std::string *> dates;
+    for (auto &l : sheet.lessons) dates[l.id] = &l.lesson_date;
+    std::unordered_set<int> students;
+    for (auto &s : sheet.students) students.insert(s.id);
+
+    for (auto &p : pending) {
+        auto date = dates.find(p.lesson_id);
+        if (date == dates.end() || !students.count(p.student_id)) continue;
+        auto &entries = sheet.grades[p.student_id];
+        auto it = std::find_if(entries.begin(), entries.end(),
+                               [&](const GradeEntry &g) { return g.lesson_date == *date->second; });
+        int grade = p.absent ? 0 : p.score;
+        if (it != entries.end()) it->grade = grade;
+        else entries.push_back({*date->second, grade});
+    }
+}
+
+// Перестройка справочников из корутины: идёт в потоке ReferenceData (pqxx блокирует),
+// корутина продолжается в IO-потоке соединения
+struct RefsRebuilt {
+    ReferenceData &refs;
+    asio::io_context &io;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) {
+        refs.rebuildAsync([&io = io, h] { asio::post(io, [h] { h.resume(); }); });
+    }
+    void await_resume() const noexcept {}
+};
+
+// BEGIN, оба INSERT и COMMIT — один конвейер libpq
+Task<crow::response> addStudentResponse(AsyncDatabase &adb, ReferenceData &refs, asio::io_context &io,
+                                        Student s, std::string login, std::string password_hash) {
+    co_await adb.addStudent(io, std::move(s), std::move(login), std::move(password_hash));
+    co_await RefsRebuilt{refs, io}; // student_count в списке групп
+
+    crow::json::wvalue res;
+    res["status"] = "success";
+    res["message"] = "Student added";
+    co_return crow::response(200, res);
+}
+
+int main() {
+    App app;
+
+    // Размер пула соединений можно задать через DB_POOL_SIZE (по умолчанию — по числу ядер)
+    size_t pool_size = 0;
+    if (const char *env = std::getenv("DB_POOL_SIZE")) pool_size = std::strtoul(env, nullptr, 10);
+    const std::string conn_str = "dbname=students_db user=admin password=admin host=db";
+    // Журнал медленных запросов: дольше DB_SLOW_MS мс (по умолчанию 200, 0 — выключен) в файл DB_SLOW_LOG или stderr
+    std::chrono::milliseconds slow_threshold(200);
+    std::string slow_log;
+    if (const char *env = std::getenv("DB_SLOW_MS")) slow_threshold = std::chrono::milliseconds(std::strtoul(env, nullptr, 10));
+    if (const char *env = std::getenv("DB_SLOW_LOG")) slow_log = env;
+    QueryStats::instance().configure(slow_threshold, slow_log);
+    Database db(conn_str, pool_size);
+    // Неблокирующие соединения для обработчиков-корутин: до DB_ASYNC_PER_THREAD на поток Crow
+    size_t async_per_thread = 32;
+    if (const char *env = std::getenv("DB_ASYNC_PER_THREAD")) async_per_thread = std::strtoul(env, nullptr, 10);
+    AsyncDatabase adb(conn_str, queryStatements(), async_per_thread);
+
+    // Пул для PBKDF2: HASH_THREADS потоков (по умолчанию половина ядер), очередь до HASH_QUEUE задач
+    size_t hash_threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+    size_t hash_queue = 256;
+    if (const char *env = std::getenv("HASH_THREADS")) hash_threads = std::strtoul(env, nullptr, 10);
+    if (const char *env = std::getenv("HASH_QUEUE")) hash_queue = std::strtoul(env, nullptr, 10);
+    HashPool hashPool(hash_threads, hash_queue);
+    // Справочники (предметы, группы, нагрузка) в памяти; изменяющие их обработчики вызывают refs.rebuild()
+    ReferenceData refs(db);
+    // Сессии: токен из /login -> пользователь; SESSION_TTL_MIN — время жизни без обращений (по умолчанию 8 ч)
+    std::chrono::minutes session_ttl(8 * 60);
+    if (const char *env = std::getenv("SESSION_TTL_MIN")) session_ttl = std::chrono::minutes(std::strtoul(env, nullptr, 10));
+    SessionStore sessions(session_ttl);
+    app.get_middleware<SessionMiddleware>().store = &sessions;
+    // Статика: web/ целиком в памяти (STATIC_WATCH=1 — перечитывать при изменениях)
+    StaticCache assets("../web");
+    if (const char *env = std::getenv("STATIC_WATCH"); env && std::string(env) == "1") assets.startWatcher();
+    // Отложенная запись оценок (GRADE_WRITE_BEHIND=1): подтверждение после локального журнала
+    // GRADE_JOURNAL, запись в БД пачкой раз в GRADE_FLUSH_MS мс или по GRADE_FLUSH_MAX ячеек
+    std::unique_ptr<GradeQueue> gradeQueue;
+    if (const char *env = std::getenv("GRADE_WRITE_BEHIND"); env && std::string(env) == "1") {
+        GradeQueue::Options options;
+        if (const char *path = std::getenv("GRADE_JOURNAL")) options.journal_path = path;
+        if (const char *ms = std::getenv("GRADE_FLUSH_MS")) options.flush_interval = std::chrono::milliseconds(std::strtoul(ms, nullptr, 10));
+        if (const char *max = std::getenv("GRADE_FLUSH_MAX")) options.flush_max = std::strtoul(max, nullptr, 10);
+        gradeQueue = std::make_unique<GradeQueue>(db, options);
+    }
+    GradeQueue *grades = gradeQueue.get(); // nullptr — оценки пишутся сразу
+
+    // Метрики: задержки по маршрутам считает MetricsMiddleware, остальное читается при выдаче /metrics
+    Metrics metrics;
+    app.get_middleware<MetricsMiddleware>().metrics = &metrics;
+    metrics.addValue("studentdb_hash_queue_depth", "PBKDF2 jobs waiting in the hash pool queue.", "gauge",
+                     [&hashPool] { return double(hashPool.stats().queue_depth); });
+    metrics.addValue("studentdb_hash_running", "PBKDF2 jobs being computed.", "gauge",
+                     [&hashPool] { return double(hashPool.stats().running); });
+    metrics.addValue("studentdb_db_pool_waiting", "Threads waiting for a pooled DB connection.", "gauge",
+                     [&db] { return double(db.poolStats().waiting); });
+    metrics.addValue("studentdb_db_pool_waits_total", "Pooled DB connection acquisitions that had to wait.", "counter",
+                     [&db] { return double(db.poolStats().waits); });
+    metrics.addValue("studentdb_db_pool_wait_seconds_total", "Time spent waiting for a pooled DB connection.", "counter",
+                     [&db] { return db.poolStats().wait_us / 1e6; });
+    metrics.addValue("studentdb_db_async_waiting", "Coroutines waiting for an async DB connection.", "gauge",
+                     [&adb] { return double(adb.stats().waiting); });
+    metrics.addValue("studentdb_db_async_waits_total", "Async DB connection acquisitions that had to wait.", "counter",
+                     [&adb] { return double(adb.stats().waits); });
+    metrics.addValue("studentdb_db_async_wait_seconds_total", "Time spent waiting for an async DB connection.", "counter",
+                     [&adb] { return adb.stats().wait_us / 1e6; });
+    if (grades) {
+        metrics.addValue("studentdb_grade_queue_size", "Grades acknowledged but not yet written to the DB.", "gauge",
+                         [grades] { return double(grades->size()); });
+    }
+
+    // HTML
+    CROW_ROUTE(app, "/")([&assets](const crow::request &req){ return assets.serve(req, "index.html"); });
+    CROW_ROUTE(app, "/admin.html")([&assets](const crow::request &req){ return assets.serve(req, "admin.html"); });
+    CROW_ROUTE(app, "/student.html")([&assets](const crow::request &req){ return assets.serve(req, "student.html"); });
+    CROW_ROUTE(app, "/teacher.html")([&assets](const crow::request &req){ return assets.serve(req, "teacher.html"); });
+
+    // JS и CSS
+    CROW_ROUTE(app, "/js/<string>")([&assets](const crow::request &req, const std::string &name){
+        return assets.serve(req, "js/" + name);
+    });
+    CROW_ROUTE(app, "/css/<string>")([&assets](const crow::request &req, const std::string &name){
+        return assets.serve(req, "css/" + name);
+    });
 
     // GET /login
-    CROW_ROUTE(app, "/login").methods("GET"_method)([]() {
-        return serveFile("index.html");
+    CROW_ROUTE(app, "/login").methods("GET"_method)([&assets](const crow::request &req) {
+        return assets.serve(req, "index.html");
     });
 
     // POST /login
-    CROW_ROUTE(app, "/login").methods("POST"_method)([&db](const crow::request &req){
+    CROW_ROUTE(app, "/login").methods("POST"_method)([&db, &hashPool, &sessions](const crow::request &req, crow::response &res){
         auto body = crow::json::load(req.body);
         if (!body || !body.has("login") || !body.has("password"))
-            return crow::response(400, crow::json::wvalue({{"error", "Invalid JSON"}}));
+            return respond(res, crow::response(400, crow::json::wvalue({{"error", "Invalid JSON"}})));
 
         std::string login = body["login"].s();
         std::string password = body["password"].s();
 
-        try {
-            User u = db.getUserByLogin(login); 
+        offloadHashing(hashPool, req, res, [&db, &sessions, login, password]() {
+            try {
+                User u = db.getUserByLogin(login); 
 
-            // Сверяем пароль через PBKDF2 (crypto.cpp)
-            if (!checkPassword(password, u.password_hash)) { 
-                return crow::response(401, crow::json::wvalue({{"error", "Неверный пароль"}}));
-            }
+                // Сверяем пароль через PBKDF2 (crypto.cpp)
+                if (!checkPassword(password, u.password_hash)) { 
+                    return crow::response(401, crow::json::wvalue({{"error", "Неверный пароль"}}));
+                }
 
-            // Если пароль верный, готовим ответ
-            crow::json::wvalue res;
-            res["status"] = "success";
-            res["role"] = u.role;
-
-            if (checkRole(u.role, "STUDENT")) {
-                int sid = db.getStudentIdByUserId(u.id);
-                if (sid != -1) {
-                    res["userId"] = sid; 
-                    res["studentId"] = sid;
+                // Если пароль верный, собираем всё, что понадобится обработчикам, и открываем сессию
+                Principal who;
+                who.user_id = u.id;
+                who.role = u.role;
+                std::transform(who.role.begin(), who.role.end(), who.role.begin(), ::toupper);
+
+                crow::json::wvalue res;
+                res["status"] = "success";
+                res["role"] = u.role;
+
+                if (checkRole(u.role, "STUDENT")) {
+                    try {
+                        Student s = db.getStudentByUserId(u.id);
+                        who.student_id = s.id;
+                        who.group_id = s.group_id;
+                    } catch (const std::exception &) {
+                        return crow::response(403, crow::json::wvalue({{"error", "Student record missing"}}));
+                    }
+                    res["userId"] = who.student_id;
+                    res["studentId"] = who.student_id;
                 } else {
-                    return crow::response(403, crow::json::wvalue({{"error", "Student record missing"}}));
+                    if (checkRole(u.role, "TEACHER")) {
+                        // Профиля в teachers может не быть (до sync_teachers) — нагрузка всё равно по users.id
+                        try { who.teacher_id = db.getTeacherByUserId(u.id).id; } catch (const std::exception &) {}
+                    }
+                    res["userId"] = u.id;
                 }
-            } else {
-                res["userId"] = u.id;
-            }
 
-            return crow::response(200, res);
+                res["token"] = sessions.create(who);
+                return crow::response(200, res);
 
-        } catch (const std::exception &e) {
-            std::cerr << "Login error: " << e.what() << std::endl;
-            return crow::response(401, crow::json::wvalue({{"error", "User not found"}}));
-        }
+            } catch (const std::exception &e) {
+                std::cerr << "Login error: " << e.what() << std::endl;
+                return crow::response(401, crow::json::wvalue({{"error", "User not found"}}));
+            }
+        });
     });
 
 
+    // POST /logout — закрыть сессию текущего токена
+    CROW_ROUTE(app, "/logout").methods("POST"_method)([&app, &sessions](const crow::request &req){
+        auto &me = session(app, req);
+        if (!me.token.empty()) sessions.erase(me.token);
+        return crow::response(200, "{\"status\":\"success\"}");
+    });
+
     // POST /users/<int>/reset_password
-    CROW_ROUTE(app, "/users/<int>/reset_password").methods("POST"_method)([&db](const crow::request &req, int id){
+    CROW_ROUTE(app, "/users/<int>/reset_password").methods("POST"_method)([&db, &hashPool](const crow::request &req, crow::response &res, int id){
         auto body = crow::json::load(req.body);
-        if (!body || !body.has("new_password")) return crow::response(400, "Invalid JSON");
-
-        std::string new_hash = hashPassword(body["new_password"].s());
-        try {
-            db.updateUserPassword(id, new_hash);
-            return crow::response(200, "Password updated");
-        } catch (...) {
-            return crow::response(500, "Error updating password");
-        }
+        if (!body || !body.has("new_password")) return respond(res, crow::response(400, "Invalid JSON"));
+
+        std::string new_password = body["new_password"].s();
+        offloadHashing(hashPool, req, res, [&db, id, new_password]() {
+            std::string new_hash = hashPassword(new_password);
+            try {
+                db.updateUserPassword(id, new_hash);
+                return crow::response(200, "Password updated");
+            } catch (...) {
+                return crow::response(500, "Error updating password");
+            }
+        });
     });
 
     // PUT /admin/users/<id>/password — Сброс пароля
-    CROW_ROUTE(app, "/admin/users/<int>/password").methods("PUT"_method)([&db](const crow::request& req, int id){
+    CROW_ROUTE(app, "/admin/users/<int>/password").methods("PUT"_method)([&db, &hashPool, &app](const crow::request& req, crow::response& res, int id){
         // Проверка прав админа
-        auto roleHeader = req.get_header_value("role");
-        if (roleHeader != "ADMIN") return crow::response(403, "Access denied");
+        if (!session(app, req).is("ADMIN")) return respond(res, crow::response(403, "Access denied"));
 
         // Парсим JSON
         auto body = crow::json::load(req.body);
         if (!body || !body.has("password")) 
-            return crow::response(400, "Invalid JSON: 'password' required");
+            return respond(res, crow::response(400, "Invalid JSON: 'password' required"));
 
         // Хешируем и сохраняем
         std::string raw_pass = body["password"].s();
-        std::string hashed_pass = hashPassword(raw_pass); // Функция из crypto.h
-
-        try {
-            db.updateUserPassword(id, hashed_pass);
-            return crow::response(200, "{\"status\":\"success\"}");
-        } catch (const std::exception& e) {
-            return crow::response(500, e.what());
-        }
+        offloadHashing(hashPool, req, res, [&db, id, raw_pass]() {
+            std::string hashed_pass = hashPassword(raw_pass); // Функция из crypto.h
+
+            try {
+                db.updateUserPassword(id, hashed_pass);
+                return crow::response(200, "{\"status\":\"success\"}");
+            } catch (const std::exception& e) {
+                return crow::response(500, e.what());
+            }
+        });
     });
 
 
     // GET /admin/users
-    CROW_ROUTE(app, "/admin/users").methods("GET"_method)([&db](const crow::request &req){
-        auto roleHeader = req.get_header_value("role");
-        if (roleHeader != "ADMIN") return crow::response(403, "Access denied");
+    CROW_ROUTE(app, "/admin/users").methods("GET"_method)([&db, &app](const crow::request &req){
+        if (!session(app, req).is("ADMIN")) return crow::response(403, "Access denied");
 
         try {
-            auto users = db.getAllUsers();
-            crow::json::wvalue res;
-            for (size_t i = 0; i < users.size(); ++i) {
-                res[i]["id"] = users[i].id;
-                res[i]["login"] = users[i].login;
-                res[i]["role"] = users[i].role;
-                res[i]["first_name"] = users[i].first_name;
-                res[i]["last_name"] = users[i].last_name;
-            }
-            return crow::response(200, res);
+            JsonWriter out;
+            PageRequest page;
+            if (pageFromQuery(req, page)) db.writeUsersPage(page, out);
+            else db.writeAllUsers(out);
+            return out.response();
 
         } catch (const std::exception& e) {
             std::cerr << "CRITICAL ERROR: " << e.what() << std::endl;
@@ -151,43 +389,49 @@ int main() {
     });
 
     // POST /admin/users
-    CROW_ROUTE(app, "/admin/users").methods("POST"_method)([&db](const crow::request &req){
+    CROW_ROUTE(app, "/admin/users").methods("POST"_method)([&db, &hashPool](const crow::request &req, crow::response &res){
         auto body = crow::json::load(req.body);
         if (!body || !body.has("login") || !body.has("password") || !body.has("role"))
-            return crow::response(400, "Invalid JSON");
+            return respond(res, crow::response(400, "Invalid JSON"));
 
         User u;
         u.login = body["login"].s();
-        u.password_hash = hashPassword(body["password"].s());
         u.role = body["role"].s();
         u.first_name = body.has("first_name") ? body["first_name"].s() : std::string("");
         u.last_name = body.has("last_name") ? body["last_name"].s() : std::string("");
+        std::string password = body["password"].s();
 
-        try {
-            // Создаем пользователя через твой метод
-            int new_id = db.addUser(u); 
+        offloadHashing(hashPool, req, res, [&db, u, password]() mutable {
+            u.password_hash = hashPassword(password);
 
-            // Синхранизируем
-            pqxx::work txn(db.getConn());
-            txn.exec_prepared("sync_teachers"); 
-            txn.commit();
+            try {
+                // Создаем пользователя через твой метод
+                int new_id = db.addUser(u); 
 
-            crow::json::wvalue res;
-            res["id"] = new_id;
-            res["status"] = "success";
-            return crow::response(200, res);
-        } catch (const std::exception &e) {
-            return crow::response(500, e.what());
-        }
+                // Синхранизируем
+                auto conn = db.acquire();
+                pqxx::work txn(*conn);
+                execQuery(txn, q::sync_teachers); 
+                txn.commit();
+
+                crow::json::wvalue res;
+                res["id"] = new_id;
+                res["status"] = "success";
+                return crow::response(200, res);
+            } catch (const std::exception &e) {
+                return crow::response(500, e.what());
+            }
+        });
     });
 
     // DELETE /admin/users/<id>
-    CROW_ROUTE(app, "/admin/users/<int>").methods("DELETE"_method)([&db](const crow::request &req, int id){
-        auto roleHeader = req.get_header_value("role");
-        if (roleHeader != "ADMIN") return crow::response(403, "Access denied");
+    CROW_ROUTE(app, "/admin/users/<int>").methods("DELETE"_method)([&db, &refs, &app, &sessions](const crow::request &req, int id){
+        if (!session(app, req).is("ADMIN")) return crow::response(403, "Access denied");
     
         try {
             db.deleteUser(id);
+            sessions.eraseIf([id](const Principal &p) { return p.user_id == id; });
+            refs.rebuild(); // вместе с пользователем уходят его нагрузка или место в группе
             return crow::response(200, "User deleted");
         } catch (...) {
             return crow::response(500, "Error deleting user");
@@ -195,30 +439,42 @@ int main() {
     });
 
     // PUT /admin/users/<id>
-    CROW_ROUTE(app, "/admin/users/<int>").methods("PUT"_method)([&db](const crow::request &req, int id){
-        auto roleHeader = req.get_header_value("role");
-        if (roleHeader != "ADMIN") return crow::response(403, "Access denied");
+    CROW_ROUTE(app, "/admin/users/<int>").methods("PUT"_method)([&db, &hashPool, &refs, &app, &sessions](const crow::request &req, crow::response &res, int id){
+        if (!session(app, req).is("ADMIN")) return respond(res, crow::response(403, "Access denied"));
 
         auto body = crow::json::load(req.body);
-        if (!body) return crow::response(400, "Invalid JSON");
+        if (!body) return respond(res, crow::response(400, "Invalid JSON"));
 
         User u;
         if (body.has("login")) u.login = body["login"].s();
-        if (body.has("password")) u.password_hash = hashPassword(body["password"].s());
         if (body.has("role")) u.role = body["role"].s();
+        if (body.has("first_name")) u.first_name = body["first_name"].s();
+        if (body.has("last_name")) u.last_name = body["last_name"].s();
+
+        auto update = [&db, &refs, &sessions, id](const User &u) {
+            try {
+                db.updateUser(id, u);
+                sessions.eraseIf([id](const Principal &p) { return p.user_id == id; }); // роль могла смениться
+                refs.rebuild();
+                return crow::response(200, "User updated");
+            } catch (...) {
+                return crow::response(500, "Error updating user");
+            }
+        };
 
-        try {
-            db.updateUser(id, u);
-            return crow::response(200, "User updated");
-        } catch (...) {
-            return crow::response(500, "Error updating user");
-        }
+        // Без смены пароля хешировать нечего — отвечаем сразу
+        if (!body.has("password")) return respond(res, update(u));
+
+        std::string password = body["password"].s();
+        offloadHashing(hashPool, req, res, [update, u, password]() mutable {
+            u.password_hash = hashPassword(password);
+            return update(u);
+        });
     });
 
     // POST /admin/courses
-    CROW_ROUTE(app, "/admin/courses").methods("POST"_method)([&db](const crow::request &req){
-        auto roleHeader = req.get_header_value("role");
-        if (roleHeader != "ADMIN") return crow::response(403, "Access denied");
+    CROW_ROUTE(app, "/admin/courses").methods("POST"_method)([&db, &refs, &app](const crow::request &req){
+        if (!session(app, req).is("ADMIN")) return crow::response(403, "Access denied");
 
         auto body = crow::json::load(req.body);
         if (!body || !body.has("name")) return crow::response(400, "Invalid JSON");
@@ -228,6 +484,7 @@ int main() {
 
         try {
             db.addCourse(c);
+            refs.rebuild();
             return crow::response(200, "Course added");
         } catch (...) {
             return crow::response(500, "Error adding course");
@@ -235,12 +492,12 @@ int main() {
     });
 
     // DELETE /admin/courses/<id>
-    CROW_ROUTE(app, "/admin/courses/<int>").methods("DELETE"_method)([&db](const crow::request &req, int id){
-        auto roleHeader = req.get_header_value("role");
-        if (roleHeader != "ADMIN") return crow::response(403, "Access denied");
+    CROW_ROUTE(app, "/admin/courses/<int>").methods("DELETE"_method)([&db, &refs, &app](const crow::request &req, int id){
+        if (!session(app, req).is("ADMIN")) return crow::response(403, "Access denied");
 
         try {
             db.deleteCourse(id);
+            refs.rebuild();
             return crow::response(200, "Course deleted");
         } catch (...) {
             return crow::response(500, "Error deleting course");
@@ -248,9 +505,8 @@ int main() {
     });
 
     // PUT /admin/courses/<id>
-    CROW_ROUTE(app, "/admin/courses/<int>").methods("PUT"_method)([&db](const crow::request &req, int id){
-        auto roleHeader = req.get_header_value("role");
-        if (roleHeader != "ADMIN") return crow::response(403, "Access denied");
+    CROW_ROUTE(app, "/admin/courses/<int>").methods("PUT"_method)([&db, &refs, &app](const crow::request &req, int id){
+        if (!session(app, req).is("ADMIN")) return crow::response(403, "Access denied");
 
         auto body = crow::json::load(req.body);
         if (!body || !body.has("name")) return crow::response(400, "Invalid JSON");
@@ -260,6 +516,7 @@ int main() {
 
         try {
             db.updateCourse(id, c);
+            refs.rebuild();
             return crow::response(200, "Course updated");
         } catch (...) {
             return crow::response(500, "Error updating course");
@@ -267,48 +524,70 @@ int main() {
     });
 
     // GET /admin/courses
-    CROW_ROUTE(app, "/admin/courses").methods("GET"_method)([&db](const crow::request& req){
-        if (req.get_header_value("role") != "ADMIN") return crow::response(403);
-        try {
-            auto courses = db.getAllCourses();
-            crow::json::wvalue res;
-            for (size_t i = 0; i < courses.size(); ++i) {
-                res[i]["id"] = courses[i].id;
-                res[i]["name"] = courses[i].name;
-            }
-            return crow::response(200, res);
-        } catch (const std::exception& e) {
-            return crow::response(500, e.what());
-        }
+    CROW_ROUTE(app, "/admin/courses").methods("GET"_method)([&refs, &app](const crow::request& req){
+        if (!session(app, req).is("ADMIN")) return crow::response(403);
+        return ReferenceData::json(refs.get()->coursesJson);
     });
 
     // GET /admin/students
     CROW_ROUTE(app, "/admin/students").methods("GET"_method)([&db](const crow::request& req){
         try {
-            auto students = db.getAllStudents();
-            crow::json::wvalue res = crow::json::wvalue::list();
-        
-            for (size_t i = 0; i < students.size(); ++i) {
-                res[i]["id"] = students[i].id;
-                res[i]["first_name"] = students[i].first_name;
-                res[i]["last_name"] = students[i].last_name;
-                res[i]["login"] = students[i].login;
-                res[i]["dob"] = students[i].dob;
-                res[i]["group_id"]= students[i].group_id;
-            }
-            return crow::response(200, res);
+            JsonWriter out(64 * 1024);
+            PageRequest page;
+            if (pageFromQuery(req, page)) db.writeStudentsPage(page, out);
+            else db.writeAllStudents(out);
+            return out.response();
         } catch (const std::exception& e) {
             return crow::response(500, e.what());
         }
     });
 
     // POST /admin/students
-    CROW_ROUTE(app, "/admin/students").methods("POST"_method)([&db](const crow::request &req){
+    // Принимает один объект студента или массив объектов (массовое создание)
+    CROW_ROUTE(app, "/admin/students").methods("POST"_method)([&db, &adb, &hashPool, &refs](const crow::request &req, crow::response &res){
         auto body = crow::json::load(req.body);
+
+        // Массив: все пароли хешируются одной пачкой (AVX2/AVX-512), вставка — одной транзакцией
+        if (body && body.t() == crow::json::type::List) {
+            std::vector<Student> students;
+            std::vector<std::string> logins, passwords;
+            for (auto &item : body) {
+                if (!item.has("first_name") || !item.has("last_name") || !item.has("dob") ||
+                    !item.has("group_id") || !item.has("login") || !item.has("password")) {
+                    return respond(res, crow::response(400, crow::json::wvalue({{"error", "Invalid JSON: missing fields"}})));
+                }
+                Student s;
+                s.first_name = item["first_name"].s();
+                s.last_name = item["last_name"].s();
+                s.dob = item["dob"].s();
+                s.group_id = item["group_id"].i();
+                students.push_back(s);
+                logins.push_back(item["login"].s());
+                passwords.push_back(item["password"].s());
+            }
+
+            return offloadHashing(hashPool, req, res, [&db, &refs, students, logins, passwords]() {
+                auto hashes = hashPasswords(passwords);
+                try {
+                    db.addStudents(students, logins, hashes);
+                    refs.rebuild(); // student_count в списке групп
+
+                    crow::json::wvalue res;
+                    res["status"] = "success";
+                    res["added"] = students.size();
+                    return crow::response(200, res);
+                } catch (const std::exception& e) {
+                    crow::json::wvalue res;
+                    res["error"] = e.what();
+                    return crow::response(500, res);
+                }
+            });
+        }
+
         if (!body || !body.has("first_name") || !body.has("last_name") || 
             !body.has("dob") || !body.has("group_id") || 
             !body.has("login") || !body.has("password")) {
-            return crow::response(400, crow::json::wvalue({{"error", "Invalid JSON: missing fields"}}));
+            return respond(res, crow::response(400, crow::json::wvalue({{"error", "Invalid JSON: missing fields"}})));
         }
     
         Student s;
@@ -318,51 +597,63 @@ int main() {
         s.group_id = body["group_id"].i();
         
         std::string login = body["login"].s();
-        std::string hashed_password = hashPassword(body["password"].s());
-    
-        try {
-            db.addStudent(s, login, hashed_password); 
-            
-            crow::json::wvalue res;
-            res["status"] = "success";
-            res["message"] = "Student added";
-            return crow::response(200, res);
+        std::string password = body["password"].s();
 
-        } catch (const std::exception& e) {
-            crow::json::wvalue res;
-            res["error"] = e.what();
-            return crow::response(500, res);
-        }
+        offloadHashing(hashPool, req, res, [&adb, &refs, io = req.io_context, s, login, password]() {
+            return addStudentResponse(adb, refs, *io, s, login, hashPassword(password));
+        });
+    });
+
+    // POST /admin/students/import — CSV: login,password,first_name,last_name,dob,group
+    CROW_ROUTE(app, "/admin/students/import").methods("POST"_method)([&db, &hashPool, &refs, &app](const crow::request &req, crow::response &res){
+        if (!session(app, req).is("ADMIN"))
+            return respond(res, crow::response(403, "Access denied"));
+
+        std::string csv = req.body;
+        offloadHashing(hashPool, req, res, [&db, &refs, csv]() {
+            std::istringstream in(csv);
+            auto progress = [](const std::string &stage, size_t done, size_t total) {
+                if (done == total) std::cout << "[INFO] Student import: " << stage << " " << done << "/" << total << std::endl;
+            };
+
+            try {
+                auto result = importStudentsCsv(db, in, progress);
+                if (result.inserted) refs.rebuild();
+
+                crow::json::wvalue res;
+                res["rows"] = result.rows;
+                res["inserted"] = result.inserted;
+                res["skipped_existing"] = result.skipped_existing;
+                res["duplicates_in_file"] = result.duplicates_in_file;
+                res["without_group"] = result.without_group;
+                res["errors"] = crow::json::wvalue::list(result.errors.begin(), result.errors.end());
+                return crow::response(200, res);
+            } catch (const std::exception& e) {
+                crow::json::wvalue res;
+                res["error"] = e.what();
+                return crow::response(500, res);
+            }
+        });
     });
 
     // GET /students/<int>/grades
-    CROW_ROUTE(app, "/students/<int>/grades").methods("GET"_method)([&db](int student_id){
-        try {
-            // Просто возвращаем результат работы метода БД
-            return crow::response(db.getStudentGrades(student_id));
-        } catch (const std::exception& e) {
-            crow::json::wvalue error;
-            error["error"] = e.what();
-            return crow::response(500, error);
-        }
+    CROW_ROUTE(app, "/students/<int>/grades").methods("GET"_method)([&adb](const crow::request& req, crow::response& res, int student_id){
+        spawn(finishAsync(res, studentGradesResponse(adb, *req.io_context, student_id)));
     });
 
     // GET /students/<int>/group
-    CROW_ROUTE(app, "/students/<int>/group")([&db](const crow::request& req, int student_id) {
-        // Мини-проверка: может ли этот пользователь смотреть эту группу?
-        return db.getGroupMembers(student_id);
+    CROW_ROUTE(app, "/students/<int>/group")([&adb](const crow::request& req, crow::response& res, int student_id) {
+        spawn(finishAsync(res, groupMembersResponse(adb, *req.io_context, student_id)));
     });
 
     // GET /student/profile
-    CROW_ROUTE(app, "/student/profile").methods("GET"_method)([&db](const crow::request& req){
-        auto role = req.get_header_value("role");
-        if (role != "STUDENT")
+    CROW_ROUTE(app, "/student/profile").methods("GET"_method)([&db, &app](const crow::request& req){
+        auto &me = session(app, req);
+        if (!me.is("STUDENT"))
             return crow::response(403, "Access denied");
 
-        int user_id = std::stoi(req.get_header_value("user_id"));
-
         try {
-            Student s = db.getStudentByUserId(user_id);
+            Student s = db.getStudentById(me.principal->student_id);
         
             crow::json::wvalue res;
             res["first_name"] = s.first_name;
@@ -378,27 +669,26 @@ int main() {
     });
 
     // GET /admin/students/<id>/profile
-    CROW_ROUTE(app, "/admin/students/<int>/profile").methods("GET"_method)([&db](const crow::request& req, int id){
-        if (req.get_header_value("role") != "ADMIN")
+    CROW_ROUTE(app, "/admin/students/<int>/profile").methods("GET"_method)([&db, &app](const crow::request& req, int id){
+        if (!session(app, req).is("ADMIN"))
             return crow::response(403, "Access denied");
 
-        auto students = db.getAllStudents();
-        for (auto &s : students) {
-            if (s.id == id) {
-                crow::json::wvalue res;
-                res["first_name"] = s.first_name;
-                res["last_name"]  = s.last_name;
-                res["dob"]        = s.dob;
-                res["group_id"]   = s.group_id;
-                return crow::response(res);
-            }
+        try {
+            Student s = db.getStudentById(id);
+            crow::json::wvalue res;
+            res["first_name"] = s.first_name;
+            res["last_name"]  = s.last_name;
+            res["dob"]        = s.dob;
+            res["group_id"]   = s.group_id;
+            return crow::response(res);
+        } catch (...) {
+            return crow::response(404, "Student not found");
         }
-        return crow::response(404, "Student not found");
     });
 
     // PUT /admin/students/<id>/profile
-    CROW_ROUTE(app, "/admin/students/<int>/profile").methods("PUT"_method)([&db](const crow::request& req, int id){
-        if (req.get_header_value("role") != "ADMIN")
+    CROW_ROUTE(app, "/admin/students/<int>/profile").methods("PUT"_method)([&db, &refs, &app, &sessions](const crow::request& req, int id){
+        if (!session(app, req).is("ADMIN"))
             return crow::response(403, "Access denied");
 
         auto body = crow::json::load(req.body);
@@ -413,6 +703,10 @@ int main() {
 
         try {
             db.updateStudent(id, s);
+            if (body.has("group_id")) {
+                sessions.eraseIf([id](const Principal &p) { return p.student_id == id; }); // group_id в сессии
+                refs.rebuild();
+            }
             return crow::response(200, "Profile updated");
         } catch (...) {
             return crow::response(500, "Error updating profile");
@@ -420,9 +714,11 @@ int main() {
     });
     
     // DELETE /admin/students/<int>
-    CROW_ROUTE(app, "/admin/students/<int>").methods("DELETE"_method)([&db](int id){
+    CROW_ROUTE(app, "/admin/students/<int>").methods("DELETE"_method)([&db, &refs, &sessions](int id){
         try {
             db.deleteStudent(id);
+            sessions.eraseIf([id](const Principal &p) { return p.student_id == id; });
+            refs.rebuild();
             return crow::response(200, "{\"status\":\"success\"}");
         } catch (const std::exception& e) {
             return crow::response(500, e.what());
@@ -430,20 +726,14 @@ int main() {
     });
 
     // GET /student/grades
-    CROW_ROUTE(app, "/student/grades").methods("GET"_method)([&db](const crow::request& req){
-        if (req.get_header_value("role") != "STUDENT")
+    CROW_ROUTE(app, "/student/grades").methods("GET"_method)([&db, &refs, &app](const crow::request& req){
+        auto &me = session(app, req);
+        if (!me.is("STUDENT"))
             return crow::response(403, "Access denied");
 
-        int user_id = std::stoi(req.get_header_value("user_id"));
-        Student s = db.getStudentByUserId(user_id);
-
-        auto grades = db.getGradesByStudent(s.id);
-        auto courses = db.getAllCourses();
-
-        // id курса -> название
-        std::unordered_map<int, std::string> courseNames;
-        for (auto &c : courses)
-            courseNames[c.id] = c.name;
+        auto grades = db.getGradesByStudent(me.principal->student_id);
+        auto refsSnap = refs.get();
+        auto &courseNames = refsSnap->courseNames; // id курса -> название
 
         // course_id -> список оценок
         std::unordered_map<int, std::vector<int>> grouped;
@@ -461,7 +751,8 @@ int main() {
             for (int g : list) sum += g;
             double avg = sum / list.size();
 
-            res[i]["course"] = courseNames[course_id];
+            auto name = courseNames.find(course_id);
+            res[i]["course"] = name != courseNames.end() ? name->second : std::string();
             res[i]["grades"] = crow::json::wvalue::list(list.begin(), list.end());
             res[i]["average"] = avg;
             i++;
@@ -471,84 +762,29 @@ int main() {
     });
 
     // GET /teacher/courses
-    CROW_ROUTE(app, "/teacher/courses").methods("GET"_method)([&db](const crow::request& req){
-        if (req.get_header_value("role") != "TEACHER") return crow::response(403);
-
-        try {
-            // Берем ID пользователя из сессии
-            int user_id = std::stoi(req.get_header_value("user_id"));
-            
-            // Сразу передаем его в метод
-            auto courses = db.getTeacherCourses(user_id);
-
-            crow::json::wvalue res;
-            for (size_t i = 0; i < courses.size(); ++i) {
-                res[i]["id"] = courses[i].course_id;
-                res[i]["name"] = courses[i].course_name;
-            }
-            return crow::response(200, res);
-        } catch (const std::exception& e) {
-            return crow::response(500, e.what());
-        }
+    CROW_ROUTE(app, "/teacher/courses").methods("GET"_method)([&refs, &app](const crow::request& req){
+        auto &me = session(app, req);
+        if (!me.is("TEACHER")) return crow::response(403);
+        return ReferenceData::json(refs.get()->teacherCourses(me.principal->user_id));
     });
 
     // GET /teacher/courses/<course_id>/groups
-    CROW_ROUTE(app, "/teacher/courses/<int>/groups").methods("GET"_method)([&db](const crow::request& req, int course_id){
-        if (req.get_header_value("role") != "TEACHER") return crow::response(403);
-        
-        try {
-            int user_id = std::stoi(req.get_header_value("user_id"));
-            
-            // Передаем и курс, и учителя
-            auto groups = db.getTeacherGroupsForCourse(course_id, user_id);
-            
-            crow::json::wvalue res;
-            for (size_t i = 0; i < groups.size(); ++i) {
-                res[i]["id"] = groups[i].group_id;
-                res[i]["name"] = groups[i].group_name;
-            }
-            return crow::response(200, res);
-        } catch (const std::exception& e) {
-            return crow::response(500, e.what());
-        }
+    CROW_ROUTE(app, "/teacher/courses/<int>/groups").methods("GET"_method)([&refs, &app](const crow::request& req, int course_id){
+        auto &me = session(app, req);
+        if (!me.is("TEACHER")) return crow::response(403);
+        return ReferenceData::json(refs.get()->teacherGroups(me.principal->user_id, course_id));
     });
 
     // GET /teacher/courses/<int>/groups/<int>/grades
-    CROW_ROUTE(app, "/teacher/courses/<int>/groups/<int>/grades").methods("GET"_method)([&db](const crow::request& req, int course_id, int group_id){
-        if (req.get_header_value("role") != "TEACHER")
+    CROW_ROUTE(app, "/teacher/courses/<int>/groups/<int>/grades").methods("GET"_method)([&db, &app, grades](const crow::request& req, int course_id, int group_id){
+        if (!session(app, req).is("TEACHER"))
             return crow::response(403, "Access denied");
 
         try {
-            // студенты группы
-            auto students = db.getStudentsByGroup(group_id);
-
-            // занятия (уроки) по курсу + группе
-            auto lessons = db.getLessons(course_id, group_id);
-
-            crow::json::wvalue res;
-
-            // даты
-            for (size_t i = 0; i < lessons.size(); ++i)
-                res["dates"][i] = lessons[i].lesson_date;
-
-            // студенты + оценки
-            for (size_t i = 0; i < students.size(); ++i) {
-                auto& s = students[i];
-
-                res["students"][i]["student_id"] = s.id;
-                res["students"][i]["student_name"] =
-                    s.last_name + " " + s.first_name;
-
-                // оценки студента
-                auto grades = db.getGradesByStudentAndCourse(s.id, course_id);
-
-                for (auto& g : grades) {
-                    res["students"][i]["grades"][g.lesson_date] =
-                        g.grade > 0 ? std::to_string(g.grade) : "Н";
-                }
-            }
-
-            return crow::response(res);
+            // студенты, занятия и оценки всей группы — одним снимком
+            auto sheet = db.getGroupGradeSheet(course_id, group_id);
+            if (grades) applyPendingGrades(sheet, grades->pending());
+            return crow::response(gradeSheetJson(sheet));
         } catch (...) {
             return crow::response(500, "Error loading grades");
         }
@@ -556,20 +792,46 @@ int main() {
 
 
     // POST /teacher/grade
-    CROW_ROUTE(app, "/teacher/grade").methods("POST"_method)([&db](const crow::request& req){
+    CROW_ROUTE(app, "/teacher/grade").methods("POST"_method)([&db, &app, grades](const crow::request& req){
+        if (!session(app, req).is("TEACHER"))
+            return crow::response(403, "Access denied");
+
         auto x = crow::json::load(req.body);
         if (!x) return crow::response(400, "Invalid JSON");
 
         try {
             int student_id = x["student_id"].i();
             int lesson_id = x["lesson_id"].i();
-            std::string grade = x["grade"].s(); // Может быть "5" или "Н"
+            std::string grade = x["grade"].s(); // Может быть "5", "Н" или "" (клетку очистили)
+
+            int score = 0;
+            bool absent = false;
+            if (!grade.empty() && !parseGrade(grade, score, absent)) return crow::response(400, "Invalid grade");
+
+            // Пустая оценка стирает ячейку
+            auto write = [&] {
+                auto conn = db.acquire();
+                pqxx::work txn(*conn);
+                if (grade.empty()) execQuery(txn, q::delete_grade, student_id, lesson_id);
+                else execQuery(txn, q::upsert_grade, student_id, lesson_id, score, absent);
+                txn.commit();
+            };
+
+            if (grades && !grade.empty()) {
+                try {
+                    grades->put(student_id, lesson_id, score, absent);
+                    return crow::response(200, "Grade updated");
+                } catch (const std::exception &e) {
+                    // Журнал недоступен — пишем напрямую, как без очереди
+                    std::cerr << "[WARN] Grade queue bypassed: " << e.what() << std::endl;
+                }
+            }
 
-            pqxx::work txn(db.getConn());
-            txn.exec_prepared("upsert_grade", student_id, lesson_id, grade);
-            txn.commit();
+            // Мимо очереди: отложенная оценка этой ячейки не должна перекрыть прямую запись
+            if (grades) grades->writeDirect({{student_id, lesson_id}}, write);
+            else write();
 
-            return crow::response(200, "Grade updated");
+            return crow::response(200, grade.empty() ? "Grade deleted" : "Grade updated");
         } catch (const std::exception& e) {
             crow::json::wvalue error;
             error["error"] = e.what();
@@ -577,34 +839,92 @@ int main() {
         }
     });
    
-    // POST /admin/teachers
-    CROW_ROUTE(app, "/admin/teachers").methods("POST"_method)([&db](const crow::request& req) {
+    // POST /teacher/grades/batch — [{student_id, lesson_id, grade}, ...] одной транзакцией
+    CROW_ROUTE(app, "/teacher/grades/batch").methods("POST"_method)([&db, &app, queue = grades](const crow::request& req){
+        if (!session(app, req).is("TEACHER"))
+            return crow::response(403, "Access denied");
+
         auto x = crow::json::load(req.body);
-        if (!x) return crow::response(400, "Invalid JSON");
+        if (!x || x.t() != crow::json::type::List)
+            return crow::response(400, "Invalid JSON: array expected");
+
+        std::vector<GradeWrite> grades;
+        grades.reserve(x.size());
+        for (auto &item : x) {
+            if (item.t() != crow::json::type::Object || !item.has("student_id") || !item.has("lesson_id") || !item.has("grade"))
+                return crow::response(400, "Invalid JSON: student_id, lesson_id and grade required");
+            // Неверный тип поля — 400, а не исключение из i()/s()
+            auto gradeType = item["grade"].t();
+            if (item["student_id"].t() != crow::json::type::Number || item["lesson_id"].t() != crow::json::type::Number ||
+                (gradeType != crow::json::type::Number && gradeType != crow::json::type::String))
+                return crow::response(400, "Invalid grade");
+            // Оценку принимаем и строкой ("5", "Н"), и числом (5)
+            std::string grade = gradeType == crow::json::type::Number
+                ? std::to_string(item["grade"].i()) : std::string(item["grade"].s());
+            grades.push_back({ (int)item["student_id"].i(), (int)item["lesson_id"].i(), grade });
+        }
 
         try {
-            std::string raw_pass = x["password"].s();
-
-            //Хешируем пароль перед передачей в БД
-            std::string hashed_pass = hashPassword(raw_pass);
-
-            db.addTeacher(
-                x["login"].s(),
-                hashed_pass,
-                x["first_name"].s(),
-                x["last_name"].s(),
-                {}
-            );
-            return crow::response(200, "{\"status\":\"success\"}");
-        }
-        catch (const std::exception& e) {
-            return crow::response(500, std::string("Error: ") + e.what());
+            // Старые оценки из очереди не должны перекрыть эти ни сейчас, ни при повторе журнала
+            std::vector<std::string> status;
+            auto write = [&] { status = db.upsertGrades(grades); };
+            if (queue) {
+                std::vector<std::pair<int, int>> cells;
+                cells.reserve(grades.size());
+                for (auto &g : grades) cells.emplace_back(g.student_id, g.lesson_id);
+                queue->writeDirect(cells, write);
+            } else {
+                write();
+            }
+
+            crow::json::wvalue res;
+            size_t applied = 0;
+            for (size_t i = 0; i < grades.size(); ++i) {
+                res["results"][i]["student_id"] = grades[i].student_id;
+                res["results"][i]["lesson_id"] = grades[i].lesson_id;
+                res["results"][i]["status"] = status[i];
+                if (status[i] == "ok") ++applied;
+            }
+            if (grades.empty()) res["results"] = crow::json::wvalue::list();
+            res["applied"] = applied;
+            return crow::response(200, res);
+        } catch (const std::exception& e) {
+            crow::json::wvalue error;
+            error["error"] = e.what();
+            return crow::response(500, error);
         }
+    });
+   
+    // POST /admin/teachers
+    CROW_ROUTE(app, "/admin/teachers").methods("POST"_method)([&db, &hashPool](const crow::request& req, crow::response& res) {
+        auto x = crow::json::load(req.body);
+        if (!x) return respond(res, crow::response(400, "Invalid JSON"));
+
+        offloadHashing(hashPool, req, res, [&db, x]() {
+            try {
+                std::string raw_pass = x["password"].s();
+
+                //Хешируем пароль перед передачей в БД
+                std::string hashed_pass = hashPassword(raw_pass);
+
+                db.addTeacher(
+                    x["login"].s(),
+                    hashed_pass,
+                    x["first_name"].s(),
+                    x["last_name"].s(),
+                    {}
+                );
+                return crow::response(200, "{\"status\":\"success\"}");
+            }
+            catch (const std::exception& e) {
+                return crow::response(500, std::string("Error: ") + e.what());
+            }
+        });
         });
     
     // PUT /admin/teachers/<id>
-    CROW_ROUTE(app, "/admin/teachers/<int>").methods("PUT"_method)([&db](const crow::request& req, int id){
-        if (req.get_header_value("role") != "ADMIN")
+    CROW_ROUTE(app, "/admin/teachers/<int>").methods("PUT"_method)([&db, &refs, &app](const crow::request& req, int id){
+        if (!session(app, req).is("ADMIN"))
             return crow::response(403, "Access denied");
     
         auto body = crow::json::load(req.body);
@@ -622,6 +942,7 @@ int main() {
     
         try {
             db.updateTeacher(id, t); // обновляет user + teacher_courses
+            refs.rebuild();
             return crow::response(200, "Teacher updated");
         } catch (...) {
             return crow::response(500, "Error updating teacher");
@@ -629,14 +950,16 @@ int main() {
     });
     
     // DELETE /admin/teachers/<id>
-    CROW_ROUTE(app, "/admin/teachers/<int>").methods("DELETE"_method)([&db](int id){
+    CROW_ROUTE(app, "/admin/teachers/<int>").methods("DELETE"_method)([&db, &refs, &sessions](int id){
         try {
-            std::lock_guard<std::mutex> lock(db.getMutex());
-            pqxx::work txn(db.getConn());
+            auto conn = db.acquire();
+            pqxx::work txn(*conn);
             
-            txn.exec_prepared("delete_user", id);
+            execQuery(txn, q::delete_user, id);
             
             txn.commit();
+            sessions.eraseIf([id](const Principal &p) { return p.user_id == id; });
+            refs.rebuild();
             
             return crow::response(200, "{\"status\":\"success\"}"); 
         } catch (const std::exception& e) {
@@ -647,60 +970,47 @@ int main() {
     });
 
     // GET /admin/groups
-    CROW_ROUTE(app, "/admin/groups").methods("GET"_method)([&db](){
-        try {
-            std::lock_guard<std::mutex> lock(db.getMutex());
-            pqxx::work txn(db.getConn());
-            
-            auto res = txn.exec_prepared("get_all_groups"); 
-            
-            crow::json::wvalue result = crow::json::wvalue::list();
-            for (size_t i = 0; i < res.size(); ++i) {
-                result[i]["id"] = res[i]["id"].as<int>();
-                result[i]["name"] = res[i]["name"].as<std::string>();
-                // Читаем количество студентов (если null, то 0)
-                result[i]["student_count"] = res[i]["student_count"].is_null() ? 0 : res[i]["student_count"].as<int>();
-            }
-            return crow::response(result);
-            
-        } catch (const std::exception& e) {
-            return crow::response(500, e.what());
-        }
+    CROW_ROUTE(app, "/admin/groups").methods("GET"_method)([&refs](){
+        return ReferenceData::json(refs.get()->groupsJson);
     });
 
     // POST /admin/groups
-    CROW_ROUTE(app, "/admin/groups").methods("POST"_method)([&db](const crow::request& req){
+    CROW_ROUTE(app, "/admin/groups").methods("POST"_method)([&db, &refs](const crow::request& req){
         auto x = crow::json::load(req.body);
         db.addGroup(x["name"].s());
+        refs.rebuild();
         return crow::response(200, "{\"status\":\"success\"}");
     });
 
     // DELITE /admin/groups/<int>
-    CROW_ROUTE(app, "/admin/groups/<int>").methods("DELETE"_method)([&db](int id){
+    CROW_ROUTE(app, "/admin/groups/<int>").methods("DELETE"_method)([&db, &refs](int id){
         db.deleteGroup(id);
+        refs.rebuild();
         return crow::response(200, "{\"status\":\"success\"}");
     });
 
     // PUT /students/<id>/password
     CROW_ROUTE(app, "/students/<int>/password").methods("PUT"_method)
-        ([&db](const crow::request& req, int student_id) {
+        ([&db, &hashPool](const crow::request& req, crow::response& res, int student_id) {
         auto x = crow::json::load(req.body);
         if (!x || !x.has("new_password"))
-            return crow::response(400, "Missing new_password");
+            return respond(res, crow::response(400, "Missing new_password"));
 
-        try {
-            // 1. Хешируем новый пароль
-            std::string raw_pass = x["new_password"].s();
-            std::string hashed_pass = hashPassword(raw_pass);
+        std::string raw_pass = x["new_password"].s();
+        offloadHashing(hashPool, req, res, [&db, student_id, raw_pass]() {
+            try {
+                // 1. Хешируем новый пароль
+                std::string hashed_pass = hashPassword(raw_pass);
 
-            // 2. Пишем в базу
-            db.updatePasswordByStudentId(student_id, hashed_pass);
+                // 2. Пишем в базу
+                db.updatePasswordByStudentId(student_id, hashed_pass);
 
-            return crow::response(200, "{\"status\":\"ok\"}");
-        }
-        catch (const std::exception& e) {
-            return crow::response(500, e.what());
-        }
+                return crow::response(200, "{\"status\":\"ok\"}");
+            }
+            catch (const std::exception& e) {
+                return crow::response(500, e.what());
+            }
+        });
     });
 
     // GET /students/<int>/profile
@@ -723,7 +1033,10 @@ int main() {
     });
 
     // POST /teacher/lessons
-    CROW_ROUTE(app, "/teacher/lessons").methods("POST"_method)([&db](const crow::request& req){
+    CROW_ROUTE(app, "/teacher/lessons").methods("POST"_method)([&db, &app](const crow::request& req){
+        if (!session(app, req).is("TEACHER"))
+            return crow::response(403, "Access denied");
+
         auto x = crow::json::load(req.body);
         if (!x) return crow::response(400, "Invalid JSON");
         
@@ -733,8 +1046,9 @@ int main() {
             std::string date = x["lesson_date"].s();
             std::string hw = x["homework"].s();
 
-            pqxx::work txn(db.getConn());
-            txn.exec_prepared("create_lesson", course_id, group_id, date, hw);
+            auto conn = db.acquire();
+            pqxx::work txn(*conn);
+            execQuery(txn, q::create_lesson, course_id, group_id, date, hw);
             txn.commit();
             
             return crow::response(200, "Lesson created");
@@ -746,110 +1060,46 @@ int main() {
     });
 
     //GET /teacher/journal
-    CROW_ROUTE(app, "/teacher/journal")([&db](const crow::request& req){
+    CROW_ROUTE(app, "/teacher/journal")([&adb, &app, grades](const crow::request& req, crow::response& res){
+        if (!session(app, req).is("TEACHER"))
+            return respond(res, crow::response(403, "Access denied"));
+
         auto course_id_str = req.url_params.get("course_id");
         auto group_id_str = req.url_params.get("group_id");
     
         if (!course_id_str || !group_id_str) 
-            return crow::response(400, "Missing course_id or group_id");
-    
+            return respond(res, crow::response(400, "Missing course_id or group_id"));
+
+        int course_id, group_id;
         try {
-            int course_id = std::stoi(course_id_str);
-            int group_id = std::stoi(group_id_str);
-        
-            pqxx::work txn(db.getConn());
-        
-            crow::json::wvalue result;
-        
-            // Уроки
-            auto lessons_res = txn.exec_prepared("get_journal_lessons", course_id, group_id);
-            std::vector<crow::json::wvalue> lessons_json;
-            for (auto row : lessons_res) {
-                crow::json::wvalue l;
-                l["id"] = row["id"].as<int>();
-                l["lesson_date"] = row["lesson_date"].as<std::string>();
-                l["homework"] = row["homework"].as<std::string>();
-                lessons_json.push_back(std::move(l));
-            }
-            result["lessons"] = std::move(lessons_json);
-        
-            // Студенты
-            auto students_res = txn.exec_prepared("get_students_by_group_", group_id);
-            
-            std::vector<crow::json::wvalue> students_json;
-            for (auto row : students_res) {
-                crow::json::wvalue s;
-                s["id"] = row["id"].as<int>();
-                s["first_name"] = row["first_name"].as<std::string>();
-                s["last_name"] = row["last_name"].as<std::string>();
-                students_json.push_back(std::move(s));
-            }
-            result["students"] = std::move(students_json);
-        
-            // Оценки
-            auto grades_res = txn.exec_prepared("get_journal_grades", course_id, group_id);
-            std::vector<crow::json::wvalue> grades_json;
-            for (auto row : grades_res) {
-                crow::json::wvalue g;
-                g["student_id"] = row["student_id"].as<int>();
-                g["lesson_id"] = row["lesson_id"].as<int>();
-                g["grade"] = row["grade"].as<std::string>();
-                grades_json.push_back(std::move(g));
-            }
-            result["grades"] = std::move(grades_json);
-        
-            txn.commit();
-            return crow::response(result);
-        
-        } catch (const std::exception& e) {
-            crow::json::wvalue error;
-            error["error"] = e.what();
-            return crow::response(500, error);
+            course_id = std::stoi(course_id_str);
+            group_id = std::stoi(group_id_str);
+        } catch (const std::exception&) {
+            return respond(res, crow::response(400, "Invalid course_id or group_id"));
         }
+        spawn(finishAsync(res, journalResponse(adb, *req.io_context, course_id, group_id,
+                                               grades ? grades->pending() : std::vector<PendingGrade>{})));
     });
 
 
     // GET /admin/teachers/load
-    CROW_ROUTE(app, "/admin/teachers/load")([&db](){
-        try {
-            std::lock_guard<std::mutex> lock(db.getMutex());
-            pqxx::work txn(db.getConn());
-            
-            auto res = txn.exec_prepared("get_all_teacher_loads");
-            
-            std::vector<crow::json::wvalue> loads;
-            for (auto row : res) {
-                crow::json::wvalue l;
-                l["teacher_id"] = row["teacher_id"].as<int>();
-                l["course_id"] = row["course_id"].as<int>();
-                l["group_id"] = row["group_id"].as<int>();
-                l["first_name"] = row["first_name"].as<std::string>();
-                l["last_name"] = row["last_name"].as<std::string>();
-                l["course_name"] = row["course_name"].as<std::string>();
-                l["group_name"] = row["group_name"].as<std::string>();
-                loads.push_back(std::move(l));
-            }
-            
-            return crow::response(200, crow::json::wvalue(loads)); 
-
-        } catch (const std::exception& e) {
-            return crow::response(500, e.what());
-        }
+    CROW_ROUTE(app, "/admin/teachers/load")([&refs](){
+        return ReferenceData::json(refs.get()->loadsJson);
     });
 
     // POST /admin/teachers/load
-    CROW_ROUTE(app, "/admin/teachers/load").methods("POST"_method)([&db](const crow::request& req){
+    CROW_ROUTE(app, "/admin/teachers/load").methods("POST"_method)([&db, &refs](const crow::request& req){
         auto x = crow::json::load(req.body);
         if (!x) return crow::response(400, "Invalid JSON");
         try {
-            std::lock_guard<std::mutex> lock(db.getMutex());
-
-            pqxx::work txn(db.getConn());
+            auto conn = db.acquire();
+            pqxx::work txn(*conn);
 
             // Вызываем метод добавления
             db.addTeacherLoad(txn, x["teacher_id"].i(), x["course_id"].i(), x["group_id"].i());
 
             txn.commit();
+            refs.rebuild();
             return crow::response(200);
             
         } catch (const std::exception& e) {
@@ -861,60 +1111,41 @@ int main() {
     });
 
     // GET /admin/teachers
-    CROW_ROUTE(app, "/admin/teachers")([&db](){
+    CROW_ROUTE(app, "/admin/teachers")([&db](const crow::request& req){
         try {
-            std::lock_guard<std::mutex> lock(db.getMutex());
-            pqxx::work txn(db.getConn());
-           
-            auto res = txn.exec_prepared("get_admin_teachers");
-            
-            std::vector<crow::json::wvalue> teachers;
-            for (auto row : res) {
-                crow::json::wvalue t;
-                t["id"] = row["id"].as<int>();
-                t["first_name"] = row["first_name"].as<std::string>();
-                t["last_name"] = row["last_name"].as<std::string>();
-                t["login"] = row["login"].as<std::string>();
-                
-                // Обрабатываем группы. Если групп нет, придет null -> заменим на пустую строку
-                if (row["group_names"].is_null()) {
-                    t["groups"] = "—";
-                } else {
-                    t["groups"] = row["group_names"].as<std::string>();
-                }
-                
-                teachers.push_back(std::move(t));
-            }
-            
-            return crow::json::wvalue(teachers);
-            
+            JsonWriter out;
+            PageRequest page;
+            if (pageFromQuery(req, page)) db.writeAdminTeachersPage(page, out);
+            else db.writeAdminTeachers(out);
+            return out.response();
         } catch (const std::exception& e) {
             std::cerr << "Error GET /admin/teachers: " << e.what() << std::endl;
-            return crow::json::wvalue({{"error", e.what()}});
+            return crow::response(crow::json::wvalue({{"error", e.what()}}));
         }
     });
 
     // DEL /admin/teachers/load
-    CROW_ROUTE(app, "/admin/teachers/load").methods("DELETE"_method)([&db](const crow::request& req){
+    CROW_ROUTE(app, "/admin/teachers/load").methods("DELETE"_method)([&db, &refs](const crow::request& req){
         auto t = req.url_params.get("t");
         auto c = req.url_params.get("c");
         auto g = req.url_params.get("g");
         if (!t || !c || !g) return crow::response(400);
 
-        pqxx::work txn(db.getConn());
-        txn.exec_prepared("delete_teacher_load", std::stoi(t), std::stoi(c), std::stoi(g));
+        auto conn = db.acquire();
+        pqxx::work txn(*conn);
+        execQuery(txn, q::delete_teacher_load, std::stoi(t), std::stoi(c), std::stoi(g));
         txn.commit();
+        refs.rebuild();
         return crow::response(200);
     });
 
     // GET /teacher/profile
-    CROW_ROUTE(app, "/teacher/profile").methods("GET"_method)([&db](const crow::request& req){
-        auto role = req.get_header_value("role");
-        if (role != "TEACHER") return crow::response(403);
+    CROW_ROUTE(app, "/teacher/profile").methods("GET"_method)([&db, &app](const crow::request& req){
+        auto &me = session(app, req);
+        if (!me.is("TEACHER")) return crow::response(403);
 
         try {
-            int user_id = std::stoi(req.get_header_value("user_id"));
-            Teacher t = db.getTeacherByUserId(user_id);
+            Teacher t = db.getTeacherByUserId(me.principal->user_id);
             
             crow::json::wvalue res;
             res["id"] = t.id;
@@ -941,9 +1172,56 @@ int main() {
         }
     });
 
-    CROW_ROUTE(app, "/css/style.css")([](){
-        crow::response res = serveFile("css/style.css");
-        res.set_header("Content-Type", "text/css");
+    // GET /admin/hash_pool — состояние пула PBKDF2
+    CROW_ROUTE(app, "/admin/hash_pool").methods("GET"_method)([&hashPool, &app](const crow::request& req){
+        if (!session(app, req).is("ADMIN")) return crow::response(403);
+
+        auto st = hashPool.stats();
+        crow::json::wvalue res;
+        res["threads"] = st.threads;
+        res["queue_depth"] = st.queue_depth;
+        res["queue_limit"] = st.queue_limit;
+        res["running"] = st.running;
+        res["completed"] = st.completed;
+        res["rejected"] = st.rejected;
+        res["avg_wait_ms"] = st.avg_wait_ms;
+        res["max_wait_ms"] = st.max_wait_ms;
+        return crow::response(200, res);
+    });
+
+    // GET /debug/queries — счётчики по запросам каталога, самые затратные первыми
+    CROW_ROUTE(app, "/debug/queries").methods("GET"_method)([&app](const crow::request& req){
+        if (!session(app, req).is("ADMIN")) return crow::response(403);
+
+        auto ms = [](std::chrono::microseconds us) { return us.count() / 1000.0; };
+        std::vector<crow::json::wvalue> list;
+        for (auto &row : QueryStats::instance().snapshot()) {
+            crow::json::wvalue q;
+            q["name"] = row.name;
+            q["calls"] = row.calls;
+            q["errors"] = row.errors;
+            q["rows"] = row.rows;
+            q["slow"] = row.slow;
+            q["total_ms"] = ms(row.total);
+            q["avg_ms"] = ms(row.total) / row.calls;
+            q["max_ms"] = ms(row.max);
+            q["wait_ms"] = ms(row.wait);
+            list.push_back(std::move(q));
+        }
+        return crow::response(200, crow::json::wvalue(list));
+    });
+
+    // DELETE /debug/queries — обнулить счётчики (например, перед нагрузочным прогоном)
+    CROW_ROUTE(app, "/debug/queries").methods("DELETE"_method)([&app](const crow::request& req){
+        if (!session(app, req).is("ADMIN")) return crow::response(403);
+        QueryStats::instance().reset();
+        return crow::response(204);
+    });
+
+    // GET /metrics — текстовый формат Prometheus (без сессии: доступ ограничивается на уровне сети)
+    CROW_ROUTE(app, "/metrics").methods("GET"_method)([&metrics](){
+        crow::response res(200, metrics.render());
+        res.set_header("Content-Type", "text/plain; version=0.0.4");
         return res;
     });
 
@@ -0,0 +1,246 @@
+#include "metrics.h"
+#include <cmath>
+#include <cstdio>
+
+// ----------------- LatencyBuckets -----------------
+
+int LatencyBuckets::index(uint64_t us) {
+    if (us < SUB) return static_cast<int>(us);
+    int exp = 63 - __builtin_clzll(us);
+    if (exp >= MAX_EXP) return COUNT - 1;
+    int sub = static_cast<int>((us >> (exp - SUB_BITS)) & (SUB - 1));
+    return (exp - SUB_BITS + 1) * SUB + sub;
+}
+
+uint64_t LatencyBuckets::upperBound(int index) {
+    if (index < SUB) return index + 1;
+    int exp = index / SUB + SUB_BITS - 1;
+    uint64_t width = 1ull << (exp - SUB_BITS);
+    return (SUB + index % SUB) * width + width;
+}
+
+// ----------------- Metrics -----------------
+
+// Единственный писатель: load + store вместо fetch_add (без lock-префикса)
+static void bump(std::atomic<uint64_t> &counter, uint64_t n = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+Metrics::ThreadState::~ThreadState() {
+    for (auto &cell : cells) delete cell.load();
+}
+
+Metrics::~Metrics() = default;
+
+Metrics::ThreadState &Metrics::local() {
+    thread_local const Metrics *owner = nullptr;
+    thread_local ThreadState *state = nullptr;
+    if (owner != this) {
+        auto fresh = std::make_unique<ThreadState>();
+        state = fresh.get();
+        owner = this;
+        std::lock_guard<std::mutex> lock(mtx_);
+        threads_.push_back(std::move(fresh));
+    }
+    return *state;
+}
+
+// Номер маршрута: общий реестр под мьютексом, но только при первом запросе маршрута в потоке
+size_t Metrics::routeId(ThreadState &state, const std::string *route, crow::HTTPMethod method) {
+    if (!route) return 0;
+    uint64_t key = reinterpret_cast<uintptr_t>(route) * 64 + static_cast<uint64_t>(method);
+    auto it = state.route_ids.find(key);
+    if (it != state.route_ids.end()) return it->second;
+
+    size_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto [pos, inserted] = route_index_.emplace(std::make_pair(route, static_cast<int>(method)), routes_.size());
+        if (inserted) {
+            if (routes_.size() < MAX_ROUTES) routes_.emplace_back(*route, crow::method_name(method));
+            else pos->second = 0;
+        }
+        id = pos->second;
+    }
+    state.route_ids.emplace(key, id);
+    return id;
+}
+
+void Metrics::requestStarted() {
+    auto &n = local().in_flight;
+    n.store(n.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void Metrics::requestFinished(const std::string *route, crow::HTTPMethod method, int status, std::chrono::microseconds latency) {
+    ThreadState &state = local();
+    size_t id = routeId(state, route, method);
+
+    RouteCell *cell = state.cells[id].load(std::memory_order_relaxed);
+    if (!cell) {
+        cell = new RouteCell();
+        state.cells[id].store(cell, std::memory_order_release);
+    }
+
+    int cls = status / 100 - 1;
+    bump(cell->status[cls >= 0 && cls < 5 ? cls : 4]);
+    if (latency.count() >= 0) {
+        auto us = static_cast<uint64_t>(latency.count());
+        bump(cell->timed);
+        bump(cell->sum_us, us);
+        bump(cell->buckets[LatencyBuckets::index(us)]);
+        auto &n = state.in_flight;
+        n.store(n.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::addValue(std::string name, std::string help, std::string type, std::function<double()> read) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    values_.push_back({std::move(name), std::move(help), std::move(type), std::move(read)});
+}
+
+static std::string escapeLabel(const std::string &value) {
+    std::string out;
+    for (char c : value) {
+        if (c == '\\' || c == '"') out += '\\';
+        if (c == '\n') {
+            out += "\\n";
+            continue;
+        }
+        out += c;
+    }
+    return out;
+}
+
+static void appendNumber(std::string &out, double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", v);
+    out += buf;
+}
+
+std::string Metrics::render() const {
+    std::vector<ThreadState *> threads;
+    std::vector<std::pair<std::string, std::string>> routes;
+    std::vector<const Value *> values;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto &t : threads_) threads.push_back(t.get());
+        routes = routes_;
+        for (auto &v : values_) values.push_back(&v);
+    }
+
+    // Сумма по потокам для каждого маршрута
+    struct Merged {
+        uint64_t status[5] = {};
+        uint64_t timed = 0, sum_us = 0;
+        std::vector<uint64_t> buckets = std::vector<uint64_t>(LatencyBuckets::COUNT);
+        bool seen = false;
+    };
+    std::vector<Merged> merged(routes.size());
+    int64_t in_flight = 0;
+    for (auto *t : threads) {
+        in_flight += t->in_flight.load(std::memory_order_relaxed);
+        for (size_t id = 0; id < routes.size(); ++id) {
+            const RouteCell *cell = t->cells[id].load(std::memory_order_acquire);
+            if (!cell) continue;
+            Merged &m = merged[id];
+            m.seen = true;
+            for (int i = 0; i < 5; ++i) m.status[i] += cell->status[i].load(std::memory_order_relaxed);
+            m.timed += cell->timed.load(std::memory_order_relaxed);
+            m.sum_us += cell->sum_us.load(std::memory_order_relaxed);
+            for (int i = 0; i < LatencyBuckets::COUNT; ++i) m.buckets[i] += cell->buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    static const double LE[] = {0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+    static const double QUANTILES[] = {0.5, 0.99, 0.999};
+
+    std::string out;
+    out.reserve(4096 + routes.size() * 2048);
+
+    out += "# HELP studentdb_http_requests_total HTTP requests by route, method and status class.\n"
+           "# TYPE studentdb_http_requests_total counter\n";
+    for (size_t id = 0; id < routes.size(); ++id) {
+        if (!merged[id].seen) continue;
+        std::string labels = "route=\"" + escapeLabel(routes[id].first) + "\",method=\"" + routes[id].second + "\"";
+        for (int i = 0; i < 5; ++i) {
+            if (!merged[id].status[i]) continue;
+            out += "studentdb_http_requests_total{" + labels + ",code=\"" + char('1' + i) + "xx\"} ";
+            out += std::to_string(merged[id].status[i]);
+            out += '\n';
+        }
+    }
+
+    out += "# HELP studentdb_http_request_duration_seconds HTTP request latency by route and method.\n"
+           "# TYPE studentdb_http_request_duration_seconds histogram\n";
+    for (size_t id = 0; id < routes.size(); ++id) {
+        const Merged &m = merged[id];
+        if (!m.timed) continue;
+        std::string labels = "route=\"" + escapeLabel(routes[id].first) + "\",method=\"" + routes[id].second + "\"";
+        // Мелкая корзина попадает в первую границу le, не меньшую её верхнего края
+        size_t b = 0;
+        uint64_t cumulative = 0;
+        for (double le : LE) {
+            while (b < m.buckets.size() && LatencyBuckets::upperBound(static_cast<int>(b)) <= le * 1e6) cumulative += m.buckets[b++];
+            out += "studentdb_http_request_duration_seconds_bucket{" + labels + ",le=\"";
+            appendNumber(out, le);
+            out += "\"} " + std::to_string(cumulative) + '\n';
+        }
+        out += "studentdb_http_request_duration_seconds_bucket{" + labels + ",le=\"+Inf\"} " + std::to_string(m.timed) + '\n';
+        out += "studentdb_http_request_duration_seconds_sum{" + labels + "} ";
+        appendNumber(out, m.sum_us / 1e6);
+        out += "\nstudentdb_http_request_duration_seconds_count{" + labels + "} " + std::to_string(m.timed) + '\n';
+    }
+
+    // Квантили из полной гистограммы (точнее, чем по корзинам le)
+    out += "# HELP studentdb_http_request_duration_quantile_seconds HTTP latency quantiles since start.\n"
+           "# TYPE studentdb_http_request_duration_quantile_seconds gauge\n";
+    for (size_t id = 0; id < routes.size(); ++id) {
+        const Merged &m = merged[id];
+        if (!m.timed) continue;
+        std::string labels = "route=\"" + escapeLabel(routes[id].first) + "\",method=\"" + routes[id].second + "\"";
+        for (double q : QUANTILES) {
+            auto rank = static_cast<uint64_t>(std::ceil(q * m.timed));
+            uint64_t cumulative = 0;
+            int b = 0;
+            for (; b < LatencyBuckets::COUNT - 1; ++b) {
+                cumulative += m.buckets[b];
+                if (cumulative >= rank) break;
+            }
+            out += "studentdb_http_request_duration_quantile_seconds{" + labels + ",quantile=\"";
+            appendNumber(out, q);
+            out += "\"} ";
+            appendNumber(out, LatencyBuckets::upperBound(b) / 1e6);
+            out += '\n';
+        }
+    }
+
+    out += "# HELP studentdb_http_requests_in_flight HTTP requests being processed.\n"
+           "# TYPE studentdb_http_requests_in_flight gauge\n"
+           "studentdb_http_requests_in_flight " + std::to_string(in_flight) + '\n';
+
+    for (auto *v : values) {
+        out += "# HELP " + v->name + ' ' + v->help + "\n# TYPE " + v->name + ' ' + v->type + '\n' + v->name + ' ';
+        appendNumber(out, v->read());
+        out += '\n';
+    }
+    return out;
+}
+
+// ----------------- MetricsMiddleware -----------------
+
+void MetricsMiddleware::before_handle(crow::request &, crow::response &, context &ctx) {
+    ctx.start = std::chrono::steady_clock::now();
+    if (metrics) metrics->requestStarted();
+}
+
+void MetricsMiddleware::after_handle(crow::request &req, crow::response &res, context &ctx) {
+    if (!metrics) return;
+    // Запрос без маршрута для своего метода Crow завершает, не вызывая before_handle
+    std::chrono::microseconds latency(-1);
+    if (ctx.start != std::chrono::steady_clock::time_point{}) {
+        latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - ctx.start);
+        ctx.start = {};
+    }
+    // req.route — локальная правка Crow, см. external/patches/crow-matched-route.patch
+    metrics->requestFinished(req.route, req.method, res.code, latency);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <crow.h>
+
+// Гистограмма задержек в духе HDR: по 8 линейных корзин на каждую степень двойки
+// (погрешность не больше 12.5%), значения в микросекундах от 1 мкс до ~19 ч.
+struct LatencyBuckets {
+    static constexpr int SUB_BITS = 3;
+    static constexpr int SUB = 1 << SUB_BITS;
+    static constexpr int MAX_EXP = 36;
+    static constexpr int COUNT = (MAX_EXP - SUB_BITS + 1) * SUB;
+
+    static int index(uint64_t us);
+    static uint64_t upperBound(int index); // исключительная верхняя граница корзины, мкс
+};
+
+// Счётчики HTTP по маршрутам (шаблон CROW_ROUTE + метод) и произвольные показатели.
+// Запись идёт только в данные своего потока: обычные атомики без блокировок,
+// с единственным писателем. Данные потоков складываются только при выдаче /metrics.
+class Metrics {
+public:
+    Metrics() = default;
+    ~Metrics();
+
+    Metrics(const Metrics &) = delete;
+    Metrics &operator=(const Metrics &) = delete;
+
+    void requestStarted();
+    // route == nullptr — запрос не дошёл до маршрута (404 и т. п.); latency < 0 — время неизвестно
+    void requestFinished(const std::string *route, crow::HTTPMethod method, int status, std::chrono::microseconds latency);
+
+    // Показатель, читаемый при выдаче (глубина очереди PBKDF2, ожидание БД и т. п.).
+    // type — "gauge" или "counter". Регистрировать до app.run()
+    void addValue(std::string name, std::string help, std::string type, std::function<double()> read);
+
+    // Текстовый формат Prometheus 0.0.4
+    std::string render() const;
+
+private:
+    static constexpr size_t MAX_ROUTES = 256; // маршруты сверх лимита считаются как "unmatched"
+
+    struct RouteCell {
+        std::array<std::atomic<uint64_t>, 5> status{}; // 1xx..5xx
+        std::atomic<uint64_t> timed{};                  // запросов с известной задержкой
+        std::atomic<uint64_t> sum_us{};
+        std::array<std::atomic<uint64_t>, LatencyBuckets::COUNT> buckets{};
+    };
+
+    struct ThreadState {
+        std::array<std::atomic<RouteCell *>, MAX_ROUTES> cells{};
+        std::atomic<int64_t> in_flight{};
+        std::unordered_map<uint64_t, size_t> route_ids; // только для своего потока
+        ~ThreadState();
+    };
+
+    struct Value {
+        std::string name, help, type;
+        std::function<double()> read;
+    };
+
+    ThreadState &local();
+    size_t routeId(ThreadState &state, const std::string *route, crow::HTTPMethod method);
+
+    mutable std::mutex mtx_; // реестры потоков и маршрутов
+    std::vector<std::unique_ptr<ThreadState>> threads_;
+    std::map<std::pair<const std::string *, int>, size_t> route_index_;
+    std::vector<std::pair<std::string, std::string>> routes_{{"unmatched", ""}}; // id -> (шаблон, метод)
+    std::vector<Value> values_;
+};
+
+// Время, код ответа и маршрут каждого запроса. Ставится первым в crow::App<...>,
+// чтобы after_handle выполнялся последним и учитывал остальные middleware.
+struct MetricsMiddleware {
+    Metrics *metrics = nullptr; // задаётся в main до app.run()
+
+    struct context {
+        std::chrono::steady_clock::time_point start{};
+    };
+
+    void before_handle(crow::request &req, crow::response &res, context &ctx);
+    void after_handle(crow::request &req, crow::response &res, context &ctx);
+};
@@ -0,0 +1,63 @@
+#include "migrations.h"
+#include "migrations_sql.h"
+#include <iostream>
+#include <iterator>
+
+// Ключ pg_advisory_xact_lock, общий для всех экземпляров сервера
+static const long long MIGRATION_LOCK_KEY = 74650012;
+
+static const char *NO_TRANSACTION_MARKER = "-- migrate: no-transaction";
+
+int runMigrations(pqxx::connection &conn) {
+    const std::string key = std::to_string(MIGRATION_LOCK_KEY);
+
+    pqxx::nontransaction(conn).exec("SELECT pg_advisory_lock(" + key + ")");
+    int current = 0, applied = 0;
+    try {
+        {
+            pqxx::work txn(conn);
+            if (txn.exec("SELECT to_regclass('schema_version')")[0][0].is_null()) {
+                txn.exec(R"(
+                    CREATE TABLE schema_version (
+                        version INT PRIMARY KEY,
+                        name TEXT NOT NULL,
+                        applied_at TIMESTAMPTZ NOT NULL DEFAULT now()
+                    );
+                )");
+            }
+            current = txn.exec("SELECT COALESCE(MAX(version), 0) FROM schema_version")[0][0].as<int>();
+            txn.commit();
+        }
+
+        for (const Migration &m : migrations::all) {
+            if (m.version <= current) continue;
+            std::string name = m.name, sql = m.sql;
+            std::string record = "INSERT INTO schema_version (version, name) VALUES (" +
+                                 std::to_string(m.version) + ", " + conn.quote(name) + ")";
+            std::cout << "[INFO] Applying migration " << name << std::endl;
+
+            if (sql.rfind(NO_TRANSACTION_MARKER, 0) == 0) {
+                pqxx::nontransaction ntx(conn);
+                ntx.exec(sql);
+                ntx.exec(record);
+            } else {
+                pqxx::work txn(conn);
+                txn.exec(sql);
+                txn.exec(record);
+                txn.commit();
+            }
+            current = m.version;
+            ++applied;
+        }
+    } catch (...) {
+        pqxx::nontransaction(conn).exec("SELECT pg_advisory_unlock(" + key + ")");
+        throw;
+    }
+    pqxx::nontransaction(conn).exec("SELECT pg_advisory_unlock(" + key + ")");
+
+    if (current > std::prev(std::end(migrations::all))->version)
+        std::cerr << "[WARN] Database schema version " << current << " is newer than the migrations built into this binary" << std::endl;
+    if (applied == 0) std::cout << "[INFO] Database schema is up to date (version " << current << ")." << std::endl;
+    else std::cout << "[INFO] Database schema migrated to version " << current << "." << std::endl;
+    return current;
+}
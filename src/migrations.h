@@ -0,0 +1,21 @@
+#pragma once
+#include <pqxx/pqxx>
+
+// Версионные миграции схемы: файлы migrations/NNN_описание.sql встраиваются при сборке
+// (см. gen_migrations.cpp и migrations_sql.h) и применяются по возрастанию NNN.
+// Номер последней применённой миграции хранится в schema_version; при старте выполняются
+// только новые, так что DDL на каждом запуске нет. Каждая миграция идёт в своей транзакции,
+// весь прогон — под advisory-блокировкой, поэтому несколько серверов не применят его дважды.
+//
+// Файл, начинающийся со строки "-- migrate: no-transaction", выполняется вне транзакции
+// (например, DO-блок с COMMIT между пачками при переносе данных). Такой файл должен содержать
+// одну команду и быть идемпотентным: при сбое он будет выполнен заново.
+struct Migration {
+    int version;
+    const char *name; // имя исходного файла, пишется в schema_version
+    const char *sql;
+};
+
+// Применяет встроенные миграции; исключение, если какая-то не прошла.
+// Возвращает текущую версию схемы.
+int runMigrations(pqxx::connection &conn);
@@ -0,0 +1,18 @@
+-- Вторичные индексы под условия из queries.sql.
+-- grades(student_id, ...) и teacher_courses(teacher_id, ...) уже покрыты PRIMARY KEY / unique_load.
+
+-- Журнал и таблица оценок: WHERE course_id = $1 AND group_id = $2 ORDER BY lesson_date
+CREATE INDEX IF NOT EXISTS lessons_course_group_date_idx ON lessons (course_id, group_id, lesson_date);
+
+-- Оценки занятия (get_journal_grades) и каскадное удаление занятий
+CREATE INDEX IF NOT EXISTS grades_lesson_id_idx ON grades (lesson_id);
+
+-- Состав группы и рейтинги
+CREATE INDEX IF NOT EXISTS students_group_id_idx ON students (group_id);
+
+-- Профиль студента по пользователю, каскадное удаление пользователя
+CREATE INDEX IF NOT EXISTS students_user_id_idx ON students (user_id);
+CREATE INDEX IF NOT EXISTS teachers_user_id_idx ON teachers (user_id);
+
+-- Группы преподавателя по курсу: WHERE course_id = $1 AND teacher_id = $2
+CREATE INDEX IF NOT EXISTS teacher_courses_course_teacher_idx ON teacher_courses (course_id, teacher_id);
@@ -0,0 +1,14 @@
+-- Оценка как число: score 1..5 или absent = true ("Н") вместо VARCHAR grade.
+-- Только изменения каталога: ADD COLUMN без вычисляемого DEFAULT не переписывает таблицу,
+-- ограничение NOT VALID не сканирует существующие строки (проверяется в 005).
+
+ALTER TABLE grades
+    ADD COLUMN IF NOT EXISTS score SMALLINT,
+    ADD COLUMN IF NOT EXISTS absent BOOLEAN NOT NULL DEFAULT false;
+
+ALTER TABLE grades ADD CONSTRAINT grades_score_check
+    CHECK ((absent AND score IS NULL) OR (NOT absent AND score BETWEEN 1 AND 5)) NOT VALID;
+
+-- Текстовый вид оценки для JSON ("1".."5" или "Н"); простая SQL-функция встраивается в запрос
+CREATE OR REPLACE FUNCTION grade_text(score SMALLINT, absent BOOLEAN) RETURNS TEXT
+    LANGUAGE sql IMMUTABLE AS $$ SELECT CASE WHEN absent THEN 'Н' ELSE score::text END $$;
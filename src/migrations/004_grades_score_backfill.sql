@@ -0,0 +1,26 @@
+-- migrate: no-transaction
+-- Перенос grade -> score/absent пачками по 5000 строк с COMMIT после каждой:
+-- блокировки строк короткие, журнал и автовакуум не получают одну огромную транзакцию.
+-- Повторный запуск безопасен: обрабатываются только ещё не перенесённые строки.
+-- NULL в grade прежняя версия показывала как "Н" — переносим как отсутствие.
+-- Пустые строки (очищенная клетка) и мусор (не 1..5 и не "Н") информации не несут и удаляются.
+DO $$
+DECLARE
+    moved INT;
+BEGIN
+    LOOP
+        UPDATE grades
+        SET absent = grade IS NULL OR grade IN ('Н', 'н'),
+            score = CASE WHEN grade IS NULL OR grade IN ('Н', 'н') THEN NULL ELSE grade::smallint END
+        WHERE ctid = ANY (ARRAY(
+            SELECT ctid FROM grades
+            WHERE score IS NULL AND NOT absent AND (grade IS NULL OR grade ~ '^[1-5]$' OR grade IN ('Н', 'н'))
+            LIMIT 5000));
+        GET DIAGNOSTICS moved = ROW_COUNT;
+        EXIT WHEN moved = 0;
+        COMMIT;
+    END LOOP;
+
+    DELETE FROM grades WHERE score IS NULL AND NOT absent;
+    COMMIT;
+END $$;
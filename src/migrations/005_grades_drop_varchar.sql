@@ -0,0 +1,4 @@
+-- Все строки перенесены: проверяем ограничение (SHARE UPDATE EXCLUSIVE, запись не блокирует)
+-- и удаляем старую колонку (только каталог, без перезаписи таблицы).
+ALTER TABLE grades VALIDATE CONSTRAINT grades_score_check;
+ALTER TABLE grades DROP COLUMN IF EXISTS grade;
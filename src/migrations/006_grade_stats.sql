@@ -0,0 +1,109 @@
+-- Накопительные суммы оценок: на студента и на (студент, предмет).
+-- Средний балл = score_sum / score_count; рейтинги читают готовые значения вместо AVG по grades.
+-- Поддерживаются триггерами в той же транзакции, что и запись оценки.
+
+CREATE TABLE student_stats (
+    student_id INT PRIMARY KEY REFERENCES students(id) ON DELETE CASCADE,
+    score_sum INT NOT NULL DEFAULT 0,
+    score_count INT NOT NULL DEFAULT 0,
+    absent_count INT NOT NULL DEFAULT 0
+);
+
+CREATE TABLE student_course_stats (
+    student_id INT NOT NULL REFERENCES students(id) ON DELETE CASCADE,
+    course_id INT NOT NULL REFERENCES courses(id) ON DELETE CASCADE,
+    score_sum INT NOT NULL DEFAULT 0,
+    score_count INT NOT NULL DEFAULT 0,
+    absent_count INT NOT NULL DEFAULT 0,
+    PRIMARY KEY (student_id, course_id)
+);
+
+-- Изменение сумм от набора строк grades (со знаком: +1 добавление, -1 удаление)
+CREATE TYPE grade_delta AS (student_id INT, lesson_id INT, score_sum INT, score_count INT, absent_count INT);
+
+-- Оценки удалённых занятий и студентов пропускаются соединением: занятия вычитаются
+-- заранее триггером lessons_stats_before_delete, строки статистики студентов удаляются каскадом.
+CREATE FUNCTION grade_stats_apply(deltas grade_delta[]) RETURNS void LANGUAGE sql AS $$
+    INSERT INTO student_course_stats AS t (student_id, course_id, score_sum, score_count, absent_count)
+    SELECT d.student_id, l.course_id, SUM(d.score_sum), SUM(d.score_count), SUM(d.absent_count)
+    FROM unnest(deltas) d
+    JOIN lessons l ON l.id = d.lesson_id
+    JOIN students s ON s.id = d.student_id
+    GROUP BY d.student_id, l.course_id
+    ON CONFLICT (student_id, course_id) DO UPDATE
+    SET score_sum = t.score_sum + EXCLUDED.score_sum,
+        score_count = t.score_count + EXCLUDED.score_count,
+        absent_count = t.absent_count + EXCLUDED.absent_count;
+
+    INSERT INTO student_stats AS t (student_id, score_sum, score_count, absent_count)
+    SELECT d.student_id, SUM(d.score_sum), SUM(d.score_count), SUM(d.absent_count)
+    FROM unnest(deltas) d
+    JOIN lessons l ON l.id = d.lesson_id
+    JOIN students s ON s.id = d.student_id
+    GROUP BY d.student_id
+    ON CONFLICT (student_id) DO UPDATE
+    SET score_sum = t.score_sum + EXCLUDED.score_sum,
+        score_count = t.score_count + EXCLUDED.score_count,
+        absent_count = t.absent_count + EXCLUDED.absent_count;
+$$;
+
+-- Триггеры уровня оператора с таблицами переходов: пакетный upsert_grades_batch
+-- обновляет суммы одним проходом, а не строкой за строкой
+CREATE FUNCTION grades_stats_trigger() RETURNS trigger LANGUAGE plpgsql AS $$
+BEGIN
+    IF TG_OP = 'INSERT' THEN
+        PERFORM grade_stats_apply(ARRAY(
+            SELECT ROW(student_id, lesson_id, COALESCE(score, 0), (score IS NOT NULL)::int, absent::int)::grade_delta
+            FROM new_rows));
+    ELSIF TG_OP = 'UPDATE' THEN
+        PERFORM grade_stats_apply(ARRAY(
+            SELECT ROW(student_id, lesson_id, COALESCE(score, 0), (score IS NOT NULL)::int, absent::int)::grade_delta
+            FROM new_rows
+            UNION ALL
+            SELECT ROW(student_id, lesson_id, -COALESCE(score, 0), -(score IS NOT NULL)::int, -absent::int)::grade_delta
+            FROM old_rows));
+    ELSE
+        PERFORM grade_stats_apply(ARRAY(
+            SELECT ROW(student_id, lesson_id, -COALESCE(score, 0), -(score IS NOT NULL)::int, -absent::int)::grade_delta
+            FROM old_rows));
+    END IF;
+    RETURN NULL;
+END $$;
+
+CREATE TRIGGER grades_stats_insert AFTER INSERT ON grades
+    REFERENCING NEW TABLE AS new_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION grades_stats_trigger();
+
+CREATE TRIGGER grades_stats_update AFTER UPDATE ON grades
+    REFERENCING OLD TABLE AS old_rows NEW TABLE AS new_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION grades_stats_trigger();
+
+CREATE TRIGGER grades_stats_delete AFTER DELETE ON grades
+    REFERENCING OLD TABLE AS old_rows
+    FOR EACH STATEMENT EXECUTE FUNCTION grades_stats_trigger();
+
+-- При удалении занятия его оценки удаляются каскадом уже после того, как строки lessons нет,
+-- и триггер на grades не узнает предмет. Поэтому вычитаем их здесь, пока занятие ещё видно.
+CREATE FUNCTION lessons_stats_before_delete() RETURNS trigger LANGUAGE plpgsql AS $$
+BEGIN
+    PERFORM grade_stats_apply(ARRAY(
+        SELECT ROW(student_id, lesson_id, -COALESCE(score, 0), -(score IS NOT NULL)::int, -absent::int)::grade_delta
+        FROM grades WHERE lesson_id = OLD.id));
+    RETURN OLD;
+END $$;
+
+CREATE TRIGGER lessons_stats_before_delete BEFORE DELETE ON lessons
+    FOR EACH ROW EXECUTE FUNCTION lessons_stats_before_delete();
+
+-- Начальное заполнение из уже выставленных оценок
+LOCK TABLE grades IN SHARE MODE;
+
+INSERT INTO student_course_stats (student_id, course_id, score_sum, score_count, absent_count)
+SELECT g.student_id, l.course_id, COALESCE(SUM(g.score), 0), COUNT(g.score), COUNT(*) FILTER (WHERE g.absent)
+FROM grades g JOIN lessons l ON l.id = g.lesson_id
+GROUP BY g.student_id, l.course_id;
+
+INSERT INTO student_stats (student_id, score_sum, score_count, absent_count)
+SELECT student_id, SUM(score_sum), SUM(score_count), SUM(absent_count)
+FROM student_course_stats
+GROUP BY student_id;
@@ -0,0 +1,4 @@
+// Ядро PBKDF2 на 8 дорожек, собирается с -mavx2
+#define PBKDF2_LANES PBKDF2_AVX2_LANES
+#define PBKDF2_KERNEL_NAME pbkdf2Sha256Avx2
+#include "pbkdf2_simd_kernel.h"
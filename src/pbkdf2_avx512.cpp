@@ -0,0 +1,4 @@
+// Ядро PBKDF2 на 16 дорожек, собирается с -mavx512f
+#define PBKDF2_LANES PBKDF2_AVX512_LANES
+#define PBKDF2_KERNEL_NAME pbkdf2Sha256Avx512
+#include "pbkdf2_simd_kernel.h"
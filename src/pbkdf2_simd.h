@@ -0,0 +1,16 @@
+#pragma once
+
+// Многобуферные ядра PBKDF2-HMAC-SHA256: каждое считает сразу несколько
+// независимых паролей (по одному в каждой дорожке SIMD-регистра).
+// keys — ключи HMAC, уже дополненные нулями до 64 байт (длинные пароли заранее хешированы).
+
+#define PBKDF2_SALT_LEN 16
+#define PBKDF2_HASH_LEN 32
+
+#define PBKDF2_AVX2_LANES 8
+#define PBKDF2_AVX512_LANES 16
+
+void pbkdf2Sha256Avx2(const unsigned char (*keys)[64], const unsigned char (*salts)[PBKDF2_SALT_LEN],
+                      int iterations, unsigned char (*out)[PBKDF2_HASH_LEN]);
+void pbkdf2Sha256Avx512(const unsigned char (*keys)[64], const unsigned char (*salts)[PBKDF2_SALT_LEN],
+                        int iterations, unsigned char (*out)[PBKDF2_HASH_LEN]);
@@ -0,0 +1,131 @@
+// Многобуферное ядро PBKDF2-HMAC-SHA256 (векторные расширения GCC).
+// Подключается из pbkdf2_avx2.cpp / pbkdf2_avx512.cpp, которые компилируются
+// с -mavx2 / -mavx512f и задают PBKDF2_LANES и PBKDF2_KERNEL_NAME.
+// Здесь нельзя подключать заголовки стандартной библиотеки: их inline-функции,
+// собранные с AVX-флагами, могли бы попасть в общий код и упасть на старых CPU.
+#include <stdint.h>
+
+#include "pbkdf2_simd.h"
+
+namespace {
+
+typedef uint32_t vec __attribute__((vector_size(PBKDF2_LANES * 4)));
+
+const uint32_t K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+const uint32_t IV256[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+inline vec rotr(vec x, int n) { return (x >> n) | (x << (32 - n)); }
+inline vec splat(uint32_t x) { return vec{} + x; }
+
+// Сжатие одного 64-байтного блока во всех дорожках сразу; w портится
+inline void compress(vec s[8], vec w[16]) {
+    vec a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int i = 0; i < 64; ++i) {
+        vec wi;
+        if (i < 16) {
+            wi = w[i];
+        } else {
+            vec w15 = w[(i - 15) & 15], w2 = w[(i - 2) & 15];
+            vec s0 = rotr(w15, 7) ^ rotr(w15, 18) ^ (w15 >> 3);
+            vec s1 = rotr(w2, 17) ^ rotr(w2, 19) ^ (w2 >> 10);
+            wi = w[i & 15] = w[i & 15] + s0 + w[(i - 7) & 15] + s1;
+        }
+        vec t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K256[i] + wi;
+        vec t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+    s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+}
+
+inline uint32_t loadBE(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+// Состояние SHA-256 после блока key ^ pad (общий префикс HMAC)
+inline void padState(vec s[8], const unsigned char (*keys)[64], unsigned char pad) {
+    vec w[16];
+    for (int j = 0; j < 16; ++j) {
+        for (int l = 0; l < PBKDF2_LANES; ++l) {
+            unsigned char b[4];
+            for (int k = 0; k < 4; ++k) b[k] = keys[l][j * 4 + k] ^ pad;
+            w[j][l] = loadBE(b);
+        }
+    }
+    for (int j = 0; j < 8; ++j) s[j] = splat(IV256[j]);
+    compress(s, w);
+}
+
+// HMAC второго и последующих раундов: сообщение — 32-байтный дайджест
+inline void hmacDigest(const vec istate[8], const vec ostate[8], const vec msg[8], vec out[8]) {
+    vec inner[8], w[16];
+    for (int j = 0; j < 8; ++j) inner[j] = istate[j];
+    for (int j = 0; j < 8; ++j) w[j] = msg[j];
+    w[8] = splat(0x80000000u);
+    for (int j = 9; j < 15; ++j) w[j] = splat(0);
+    w[15] = splat((64 + 32) * 8);
+    compress(inner, w);
+
+    for (int j = 0; j < 8; ++j) out[j] = ostate[j];
+    for (int j = 0; j < 8; ++j) w[j] = inner[j];
+    w[8] = splat(0x80000000u);
+    for (int j = 9; j < 15; ++j) w[j] = splat(0);
+    w[15] = splat((64 + 32) * 8);
+    compress(out, w);
+}
+
+} // namespace
+
+void PBKDF2_KERNEL_NAME(const unsigned char (*keys)[64], const unsigned char (*salts)[PBKDF2_SALT_LEN],
+                        int iterations, unsigned char (*out)[PBKDF2_HASH_LEN]) {
+    vec istate[8], ostate[8];
+    padState(istate, keys, 0x36);
+    padState(ostate, keys, 0x5c);
+
+    // U1 = HMAC(P, salt || INT(1)): соль 16 байт + 4 байта счётчика помещаются в один блок
+    vec w[16], inner[8], u[8], t[8];
+    for (int j = 0; j < 4; ++j) {
+        for (int l = 0; l < PBKDF2_LANES; ++l) w[j][l] = loadBE(salts[l] + j * 4);
+    }
+    w[4] = splat(1);
+    w[5] = splat(0x80000000u);
+    for (int j = 6; j < 15; ++j) w[j] = splat(0);
+    w[15] = splat((64 + PBKDF2_SALT_LEN + 4) * 8);
+    for (int j = 0; j < 8; ++j) inner[j] = istate[j];
+    compress(inner, w);
+
+    for (int j = 0; j < 8; ++j) u[j] = ostate[j];
+    for (int j = 0; j < 8; ++j) w[j] = inner[j];
+    w[8] = splat(0x80000000u);
+    for (int j = 9; j < 15; ++j) w[j] = splat(0);
+    w[15] = splat((64 + 32) * 8);
+    compress(u, w);
+    for (int j = 0; j < 8; ++j) t[j] = u[j];
+
+    // U2..Un, T = U1 ^ U2 ^ ... ^ Un
+    for (int i = 1; i < iterations; ++i) {
+        hmacDigest(istate, ostate, u, u);
+        for (int j = 0; j < 8; ++j) t[j] ^= u[j];
+    }
+
+    for (int l = 0; l < PBKDF2_LANES; ++l) {
+        for (int j = 0; j < 8; ++j) {
+            uint32_t x = t[j][l];
+            out[l][j * 4 + 0] = (unsigned char)(x >> 24);
+            out[l][j * 4 + 1] = (unsigned char)(x >> 16);
+            out[l][j * 4 + 2] = (unsigned char)(x >> 8);
+            out[l][j * 4 + 3] = (unsigned char)x;
+        }
+    }
+}
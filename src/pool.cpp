@@ -0,0 +1,171 @@
+#include "pool.h"
+#include <iostream>
+#include <stdexcept>
+
+ConnectionPool::Handle::~Handle() {
+    if (pool_ && conn_) pool_->release(std::move(conn_));
+}
+
+ConnectionPool::ConnectionPool(const std::string &conn_str, size_t max_size,
+                               std::chrono::milliseconds acquire_timeout,
+                               std::chrono::seconds health_check_after)
+    : conn_str_(conn_str),
+      max_size_(max_size == 0 ? 1 : max_size),
+      acquire_timeout_(acquire_timeout),
+      health_check_after_(health_check_after) {
+    // Первое соединение открываем сразу, чтобы ошибка подключения была видна при старте
+    auto first = connect();
+    std::lock_guard<std::mutex> lock(mtx_);
+    idle_.push_back({std::move(first), Clock::now()});
+    open_ = 1;
+}
+
+// Новое соединение + подготовка всех известных запросов
+std::unique_ptr<pqxx::connection> ConnectionPool::connect() {
+    auto c = std::make_unique<pqxx::connection>(conn_str_);
+    prepare(*c);
+    return c;
+}
+
+// Весь каталог одним сообщением из PREPARE (один сетевой круг вместо сотни).
+// Если какой-то запрос не готовится, повторяем по одному, чтобы в логе было видно какой
+void ConnectionPool::prepare(pqxx::connection &c) {
+    std::vector<std::pair<std::string, std::string>> statements;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        statements = statements_;
+    }
+    if (statements.empty()) return;
+
+    std::string batch;
+    for (auto &[name, sql] : statements) batch += "PREPARE " + c.quote_name(name) + " AS " + sql + ";\n";
+    try {
+        pqxx::nontransaction txn(c);
+        txn.exec(batch);
+        return;
+    } catch (const std::exception &) {
+    }
+
+    {
+        pqxx::nontransaction txn(c);
+        txn.exec("DEALLOCATE ALL");
+    }
+    for (auto &[name, sql] : statements) {
+        try {
+            c.prepare(name, sql);
+        } catch (const std::exception &e) {
+            std::cerr << "Error preparing " << name << ": " << e.what() << std::endl;
+        }
+    }
+}
+
+// Проверка соединения, которое долго простаивало
+bool ConnectionPool::isHealthy(pqxx::connection &c) {
+    if (!c.is_open()) return false;
+    try {
+        pqxx::nontransaction ping(c);
+        ping.exec("SELECT 1");
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "[WARN] Pooled connection failed health check: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+static thread_local std::chrono::microseconds last_wait{0};
+
+std::chrono::microseconds ConnectionPool::takeWait() {
+    return std::exchange(last_wait, std::chrono::microseconds(0));
+}
+
+ConnectionPool::Handle ConnectionPool::acquire() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    last_wait = std::chrono::microseconds(0);
+
+    auto available = [this] { return !idle_.empty() || open_ < max_size_; };
+    bool ready = available();
+    if (!ready) {
+        auto start = Clock::now();
+        ++waiting_;
+        ready = cv_.wait_for(lock, acquire_timeout_, available);
+        --waiting_;
+        ++waits_;
+        last_wait = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+        wait_us_ += last_wait.count();
+    }
+    if (!ready) {
+        throw std::runtime_error("Connection pool exhausted: no free connection within timeout");
+    }
+
+    if (!idle_.empty()) {
+        // Берём последнее возвращённое соединение: оно "теплее" остальных
+        Idle item = std::move(idle_.back());
+        idle_.pop_back();
+        lock.unlock();
+
+        bool stale = Clock::now() - item.last_used > health_check_after_;
+        if (!item.conn->is_open() || (stale && !isHealthy(*item.conn))) {
+            // Переподключаемся вместо сломанного соединения
+            try {
+                item.conn = connect();
+            } catch (...) {
+                std::lock_guard<std::mutex> relock(mtx_);
+                --open_;
+                cv_.notify_one();
+                throw;
+            }
+        }
+        return Handle(this, std::move(item.conn));
+    }
+
+    // Свободных нет, но лимит не достигнут: открываем новое
+    ++open_;
+    lock.unlock();
+    try {
+        return Handle(this, connect());
+    } catch (...) {
+        std::lock_guard<std::mutex> relock(mtx_);
+        --open_;
+        cv_.notify_one();
+        throw;
+    }
+}
+
+void ConnectionPool::release(std::unique_ptr<pqxx::connection> conn) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (conn->is_open()) {
+        idle_.push_back({std::move(conn), Clock::now()});
+    } else {
+        // Соединение разорвано: освобождаем слот, при следующем acquire откроется новое
+        --open_;
+    }
+    cv_.notify_one();
+}
+
+void ConnectionPool::prepareAll(const std::vector<std::pair<std::string, std::string>> &statements) {
+    std::vector<Idle> idle;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        statements_ = statements;
+        idle.swap(idle_);
+    }
+    // Готовим запросы на уже открытых соединениях и возвращаем их в пул
+    for (auto &item : idle) prepare(*item.conn);
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto &item : idle) idle_.push_back(std::move(item));
+    cv_.notify_all();
+}
+
+size_t ConnectionPool::openConnections() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return open_;
+}
+
+size_t ConnectionPool::idleConnections() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return idle_.size();
+}
+
+ConnectionPool::Stats ConnectionPool::stats() const {
+    return {waits_.load(), wait_us_.load(), waiting_.load()};
+}
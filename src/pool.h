@@ -0,0 +1,89 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <chrono>
+#include <utility>
+#include <pqxx/pqxx>
+
+// Пул соединений с PostgreSQL.
+// Соединения создаются лениво (до max_size), выдаются через RAII-хендл
+// и возвращаются в пул при его разрушении.
+class ConnectionPool {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Хендл соединения: пока он жив, соединение занято текущим потоком
+    class Handle {
+    public:
+        Handle(ConnectionPool *pool, std::unique_ptr<pqxx::connection> conn)
+            : pool_(pool), conn_(std::move(conn)) {}
+        Handle(Handle &&other) noexcept = default;
+        Handle &operator=(Handle &&other) = delete;
+        Handle(const Handle &) = delete;
+        Handle &operator=(const Handle &) = delete;
+        ~Handle();
+
+        pqxx::connection &operator*() { return *conn_; }
+        pqxx::connection *operator->() { return conn_.get(); }
+
+    private:
+        ConnectionPool *pool_;
+        std::unique_ptr<pqxx::connection> conn_;
+    };
+
+    ConnectionPool(const std::string &conn_str, size_t max_size,
+                   std::chrono::milliseconds acquire_timeout = std::chrono::seconds(5),
+                   std::chrono::seconds health_check_after = std::chrono::seconds(30));
+
+    // Взять соединение из пула (ждёт освобождения, если все заняты)
+    Handle acquire();
+
+    // Запомнить подготовленные запросы и подготовить их на всех соединениях
+    void prepareAll(const std::vector<std::pair<std::string, std::string>> &statements);
+
+    size_t maxSize() const { return max_size_; }
+    size_t openConnections();
+    size_t idleConnections();
+
+    // Ожидание свободного соединения (для /metrics)
+    struct Stats {
+        uint64_t waits = 0;   // acquire(), которым пришлось ждать
+        uint64_t wait_us = 0; // суммарное время ожидания
+        int64_t waiting = 0;  // ждут прямо сейчас
+    };
+    Stats stats() const;
+
+    // Сколько ждал последний acquire() этого потока; обнуляется при чтении,
+    // чтобы ожидание досталось первому запросу на полученном соединении (QueryStats)
+    static std::chrono::microseconds takeWait();
+
+private:
+    struct Idle {
+        std::unique_ptr<pqxx::connection> conn;
+        Clock::time_point last_used;
+    };
+
+    std::unique_ptr<pqxx::connection> connect();
+    void prepare(pqxx::connection &c);
+    bool isHealthy(pqxx::connection &c);
+    void release(std::unique_ptr<pqxx::connection> conn);
+
+    std::string conn_str_;
+    size_t max_size_;
+    std::chrono::milliseconds acquire_timeout_;
+    std::chrono::seconds health_check_after_;
+
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<Idle> idle_;
+    size_t open_ = 0;
+    std::vector<std::pair<std::string, std::string>> statements_;
+
+    std::atomic<uint64_t> waits_{0}, wait_us_{0};
+    std::atomic<int64_t> waiting_{0};
+};
@@ -7,8 +7,11 @@ INSERT INTO users (login, password_hash, role, first_name, last_name) VALUES ($1
 -- name: get_all_users
 SELECT id, login, role, first_name, last_name FROM users ORDER BY id
 
+-- name: get_users_page
+SELECT id, login, role, first_name, last_name FROM users WHERE id > $1 ORDER BY id LIMIT $2
+
 -- name: update_user
-UPDATE users SET login=$1, role=$2, first_name=$3, last_name=$4 WHERE id=$5
+UPDATE users SET login=COALESCE(NULLIF($1, ''), login), role=COALESCE(NULLIF($2, ''), role), first_name=COALESCE(NULLIF($3, ''), first_name), last_name=COALESCE(NULLIF($4, ''), last_name) WHERE id=$5
 
 -- name: update_user_password
 UPDATE users SET password_hash=$1 WHERE id=$2
@@ -31,21 +34,36 @@ SELECT id, password, role FROM users WHERE login = $1
 -- name: insert_student
 INSERT INTO students (user_id, dob, group_id) VALUES ($1, $2, $3)
 
+-- name: insert_student_for_login
+INSERT INTO students (user_id, dob, group_id) SELECT id, $2::date, $3::int FROM users WHERE login = $1
+
 -- name: get_all_students
 SELECT s.id, s.user_id, u.first_name, u.last_name, u.login, s.dob, s.group_id FROM students s LEFT JOIN users u ON s.user_id = u.id ORDER BY s.id
 
 
+-- name: get_students_page
+SELECT s.id, s.user_id, u.first_name, u.last_name, u.login, s.dob, s.group_id FROM students s LEFT JOIN users u ON s.user_id = u.id WHERE s.id > $1 ORDER BY s.id LIMIT $2
+
 -- name: get_students_by_group
 SELECT s.id, s.user_id, u.first_name, u.last_name, u.login, s.dob, s.group_id FROM students s JOIN users u ON s.user_id = u.id WHERE s.group_id = $1 ORDER BY u.last_name
 
 -- name: update_student
 UPDATE students SET dob=$1, group_id=$2 WHERE id=$3
 
+-- name: update_student_user
+UPDATE users SET first_name=COALESCE(NULLIF($1, ''), first_name), last_name=COALESCE(NULLIF($2, ''), last_name) WHERE id = (SELECT user_id FROM students WHERE id = $3)
+
 -- name: delete_student
 DELETE FROM students WHERE id = $1
 
+-- name: delete_student_user
+DELETE FROM users WHERE id = (SELECT user_id FROM students WHERE id = $1)
+
+-- name: get_grades_by_student
+SELECT g.student_id, l.course_id, g.score, g.absent, l.lesson_date FROM grades g JOIN lessons l ON l.id = g.lesson_id WHERE g.student_id = $1 ORDER BY l.lesson_date
+
 -- name: get_student_grades
-SELECT c.id as course_id, c.name as course_name, g.grade, l.lesson_date as date_assigned 
+SELECT c.id as course_id, c.name as course_name, grade_text(g.score, g.absent) AS grade, l.lesson_date as date_assigned 
 FROM grades g 
 JOIN lessons l ON g.lesson_id = l.id 
 JOIN courses c ON l.course_id = c.id 
@@ -60,7 +78,11 @@ LEFT JOIN groups g ON s.group_id = g.id
 WHERE s.id = $1
 
 -- name: get_group_rating
-SELECT u.first_name, u.last_name, AVG(CASE WHEN g.grade ~ '^[0-9]+$' THEN g.grade::integer ELSE NULL END) as avg_grade FROM students s JOIN users u ON s.user_id = u.id LEFT JOIN grades g ON s.id = g.student_id WHERE s.group_id = (SELECT group_id FROM students WHERE id = $1) GROUP BY s.id, u.first_name, u.last_name ORDER BY avg_grade DESC NULLS LAST
+SELECT s.id, u.first_name, u.last_name, st.score_sum, st.score_count
+FROM students s
+JOIN users u ON s.user_id = u.id
+LEFT JOIN student_stats st ON st.student_id = s.id
+WHERE s.group_id = (SELECT group_id FROM students WHERE id = $1)
 
 -- name: get_sid_by_uid
 SELECT id FROM students WHERE user_id = $1
@@ -84,16 +106,6 @@ DELETE FROM groups WHERE id = $1
 -- name: update_group
 UPDATE groups SET name = $1 WHERE id = $2
 
--- name: get_group_members
-SELECT u.first_name, u.last_name, 
-       AVG(CASE WHEN g.grade ~ '^[0-9]+$' THEN g.grade::integer ELSE NULL END) as avg_grade 
-FROM students s 
-JOIN users u ON s.user_id = u.id 
-LEFT JOIN grades g ON s.id = g.student_id 
-WHERE s.group_id = (SELECT group_id FROM students WHERE id = $1) 
-GROUP BY s.id, u.first_name, u.last_name 
-ORDER BY avg_grade DESC NULLS LAST
-
 -- name: get_students_by_group_
 SELECT s.id, u.first_name, u.last_name FROM students s JOIN users u ON s.user_id = u.id WHERE s.group_id = $1 ORDER BY u.last_name, u.first_name
 
@@ -128,10 +140,39 @@ INSERT INTO lessons (course_id, group_id, lesson_date, homework) VALUES ($1, $2,
 SELECT id, lesson_date, homework FROM lessons WHERE course_id = $1 AND group_id = $2 ORDER BY lesson_date
 
 -- name: get_grade_by_student_lesson
-SELECT grade FROM grades WHERE student_id=$1 AND lesson_id=$2
+SELECT grade_text(score, absent) AS grade FROM grades WHERE student_id=$1 AND lesson_id=$2
+
+-- name: get_grade_table
+SELECT s.id AS student_id, u.first_name, u.last_name, l.id AS lesson_id, l.lesson_date, grade_text(g.score, g.absent) AS grade
+FROM students s
+JOIN users u ON s.user_id = u.id
+JOIN lessons l ON l.course_id = $1 AND l.group_id = s.group_id
+LEFT JOIN grades g ON g.student_id = s.id AND g.lesson_id = l.id
+WHERE s.group_id = $2
+ORDER BY u.last_name, s.id, l.lesson_date, l.id
 
 -- name: upsert_grade
-INSERT INTO grades (student_id, lesson_id, grade) VALUES ($1, $2, $3) ON CONFLICT (student_id, lesson_id) DO UPDATE SET grade = EXCLUDED.grade
+INSERT INTO grades (student_id, lesson_id, score, absent) VALUES ($1, $2, NULLIF($3::smallint, 0), $4) ON CONFLICT (student_id, lesson_id) DO UPDATE SET score = EXCLUDED.score, absent = EXCLUDED.absent
+
+-- name: upsert_grade_by_date
+INSERT INTO grades (student_id, lesson_id, score, absent) SELECT $1::int, l.id, NULLIF($4::smallint, 0), $5::boolean FROM lessons l WHERE l.course_id = $2 AND l.lesson_date = $3::date ORDER BY l.id LIMIT 1 ON CONFLICT (student_id, lesson_id) DO UPDATE SET score = EXCLUDED.score, absent = EXCLUDED.absent RETURNING lesson_id
+
+-- name: upsert_grades_batch
+INSERT INTO grades (student_id, lesson_id, score, absent)
+SELECT v.student_id, v.lesson_id, v.score, v.absent
+FROM unnest($1::int[], $2::int[], $3::smallint[], $4::boolean[]) AS v(student_id, lesson_id, score, absent)
+WHERE EXISTS (SELECT 1 FROM students s WHERE s.id = v.student_id)
+  AND EXISTS (SELECT 1 FROM lessons l WHERE l.id = v.lesson_id)
+ON CONFLICT (student_id, lesson_id) DO UPDATE SET score = EXCLUDED.score, absent = EXCLUDED.absent
+RETURNING student_id, lesson_id
+
+-- name: delete_grade
+DELETE FROM grades WHERE student_id = $1 AND lesson_id = $2
+
+-- name: delete_grades_batch
+DELETE FROM grades g
+USING unnest($1::int[], $2::int[]) AS v(student_id, lesson_id)
+WHERE g.student_id = v.student_id AND g.lesson_id = v.lesson_id
 
 -- name: get_all_teachers
 SELECT u.id AS user_id, u.login, u.first_name, u.last_name, g.id AS group_id, g.name AS group_name FROM users u LEFT JOIN teacher_groups tg ON u.id = tg.teacher_id LEFT JOIN groups g ON tg.group_id = g.id WHERE u.role='TEACHER' ORDER BY u.last_name
@@ -166,6 +207,17 @@ LEFT JOIN groups g ON tc.group_id = g.id
 GROUP BY u.id, u.first_name, u.last_name, u.login
 ORDER BY u.last_name
 
+-- name: get_admin_teachers_page
+SELECT u.id as id, u.first_name, u.last_name, u.login,
+       (SELECT STRING_AGG(DISTINCT g.name, ', ')
+        FROM teacher_courses tc JOIN groups g ON tc.group_id = g.id
+        WHERE tc.teacher_id = u.id) as group_names
+FROM users u
+WHERE EXISTS (SELECT 1 FROM teachers t WHERE t.user_id = u.id)
+  AND u.id > $1
+ORDER BY u.id
+LIMIT $2
+
 -- name: insert_teacher_profile
 INSERT INTO teachers (user_id) VALUES ($1) RETURNING id
 
@@ -208,26 +260,32 @@ ORDER BY g.name
 SELECT DISTINCT g.id, g.name FROM lessons l JOIN groups g ON g.id = l.group_id WHERE l.course_id = $1
 
 -- name: get_journal_grades
-SELECT student_id, lesson_id, grade FROM grades WHERE lesson_id IN (SELECT id FROM lessons WHERE course_id = $1 AND group_id = $2)
+SELECT student_id, lesson_id, grade_text(score, absent) AS grade FROM grades WHERE lesson_id IN (SELECT id FROM lessons WHERE course_id = $1 AND group_id = $2)
 
 -- name: update_teacher_user
 UPDATE users SET login=$1, first_name=$2, last_name=$3 WHERE id=$4
 
 -- name: get_grades_for_predict
-SELECT g.grade 
+SELECT g.score 
 FROM grades g 
 JOIN lessons l ON g.lesson_id = l.id 
-WHERE g.student_id = $1 AND l.course_id = $2 
+WHERE g.student_id = $1 AND l.course_id = $2 AND NOT g.absent 
 ORDER BY l.lesson_date ASC
 
 -- name: get_student_by_user_id
 SELECT s.id, s.user_id, u.first_name, u.last_name, u.login, s.dob, s.group_id FROM students s JOIN users u ON s.user_id = u.id WHERE s.user_id = $1
 
--- name: get_group_list_avg
-SELECT u.first_name, u.last_name, AVG(CAST(g.grade AS INTEGER)) as avg_score FROM students s JOIN users u ON s.user_id = u.id LEFT JOIN grades g ON s.id = g.student_id WHERE s.group_id = $1 GROUP BY u.id, u.first_name, u.last_name ORDER BY avg_score DESC
+-- name: get_student_by_id
+SELECT s.id, s.user_id, u.first_name, u.last_name, u.login, s.dob, s.group_id FROM students s JOIN users u ON s.user_id = u.id WHERE s.id = $1
+
+-- name: get_student_by_login
+SELECT s.id, s.user_id, u.first_name, u.last_name, u.login, s.dob, s.group_id FROM students s JOIN users u ON s.user_id = u.id WHERE u.login = $1
 
 -- name: get_grades_by_student_course
-SELECT l.lesson_date, g.grade FROM grades g JOIN lessons l ON l.id = g.lesson_id WHERE g.student_id = $1 AND l.course_id = $2
+SELECT l.lesson_date, g.score FROM grades g JOIN lessons l ON l.id = g.lesson_id WHERE g.student_id = $1 AND l.course_id = $2
+
+-- name: get_grades_by_group_course
+SELECT g.student_id, l.lesson_date, g.score FROM grades g JOIN lessons l ON l.id = g.lesson_id JOIN students s ON s.id = g.student_id WHERE s.group_id = $1 AND l.course_id = $2
 
 -- name: update_password_by_student_id
 UPDATE users SET password_hash = $1 
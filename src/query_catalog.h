@@ -0,0 +1,48 @@
+#pragma once
+#include <chrono>
+#include <pqxx/pqxx>
+#include <utility>
+#include "pool.h"
+#include "query_stats.h"
+
+// Запрос из queries.sql, встроенный при сборке (см. gen_queries.cpp и queries.h).
+// Arity — число параметров $1..$N: вызов с другим числом аргументов не скомпилируется.
+template <int Arity>
+struct Query {
+    const char *name; // имя подготовленного запроса
+    const char *sql;
+    static constexpr int arity = Arity;
+};
+
+// Запись каталога q::all для подготовки всех запросов на соединении
+struct QueryInfo {
+    const char *name;
+    const char *sql;
+    int arity;
+
+    template <int N>
+    constexpr QueryInfo(const Query<N> &q) : name(q.name), sql(q.sql), arity(N) {}
+};
+
+// exec_prepared с проверкой числа аргументов при компиляции. Время, строки и ожидание
+// соединения пула учитываются в QueryStats; медленный запрос попадает в журнал
+// с обезличенными параметрами
+template <int N, typename... Args>
+pqxx::result execQuery(pqxx::transaction_base &txn, const Query<N> &q, Args &&...args) {
+    static_assert(sizeof...(Args) == N, "wrong number of query parameters");
+    using Clock = std::chrono::steady_clock;
+    auto &stats = QueryStats::instance();
+    auto wait = ConnectionPool::takeWait();
+    auto start = Clock::now();
+    pqxx::result r;
+    try {
+        r = txn.exec_prepared(q.name, args...);
+    } catch (...) {
+        stats.record(q.name, std::chrono::duration_cast<QueryStats::Micros>(Clock::now() - start), 0, wait, true);
+        throw;
+    }
+    auto elapsed = std::chrono::duration_cast<QueryStats::Micros>(Clock::now() - start);
+    stats.record(q.name, elapsed, r.size(), wait, false);
+    if (stats.isSlow(elapsed)) stats.logSlow(q.name, elapsed, r.size(), wait, {redactParam(args)...});
+    return r;
+}
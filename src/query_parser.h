@@ -0,0 +1,52 @@
+#pragma once
+// Разбор queries.sql: блоки "-- name: <имя>" и число параметров $N.
+// Используется генератором gen_queries (при сборке) и bench_micro.
+#include <algorithm>
+#include <cctype>
+#include <istream>
+#include <string>
+#include <vector>
+
+struct QueryStatement {
+    std::string name;
+    std::string sql;
+    int arity = 0;
+};
+
+inline std::string trimQueryLine(const std::string &str) {
+    size_t first = str.find_first_not_of(" \t\n\r");
+    if (first == std::string::npos) return "";
+    size_t last = str.find_last_not_of(" \t\n\r");
+    return str.substr(first, last - first + 1);
+}
+
+// Блоки "-- name: <имя>" + SQL до следующего имени; строки SQL склеиваются через пробел
+inline std::vector<QueryStatement> parseQueries(std::istream &in) {
+    std::vector<QueryStatement> statements;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string trimmed = trimQueryLine(line);
+        if (trimmed.empty()) continue;
+        if (trimmed.rfind("-- name:", 0) == 0) {
+            statements.push_back({trimQueryLine(trimmed.substr(8)), "", 0});
+        } else if (!statements.empty()) {
+            if (!statements.back().sql.empty()) statements.back().sql += ' ';
+            statements.back().sql += trimmed;
+        }
+    }
+    return statements;
+}
+
+// Наибольший номер параметра $N вне строковых литералов
+inline int queryArity(const std::string &sql) {
+    int max = 0;
+    bool quoted = false;
+    for (size_t i = 0; i < sql.size(); ++i) {
+        if (sql[i] == '\'') quoted = !quoted;
+        if (quoted || sql[i] != '$' || i + 1 >= sql.size() || !std::isdigit(static_cast<unsigned char>(sql[i + 1]))) continue;
+        int n = 0;
+        while (i + 1 < sql.size() && std::isdigit(static_cast<unsigned char>(sql[i + 1]))) n = n * 10 + (sql[++i] - '0');
+        max = std::max(max, n);
+    }
+    return max;
+}
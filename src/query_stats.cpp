@@ -0,0 +1,103 @@
+#include "query_stats.h"
+#include "queries.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+
+QueryStats &QueryStats::instance() {
+    static QueryStats stats;
+    return stats;
+}
+
+QueryStats::QueryStats() : cells_(new Cell[std::size(q::all)]) {
+    for (auto &query : q::all) {
+        index_.emplace(query.name, names_.size());
+        names_.push_back(query.name);
+    }
+}
+
+QueryStats::~QueryStats() {
+    if (log_) std::fclose(log_);
+}
+
+void QueryStats::configure(std::chrono::milliseconds threshold, const std::string &log_path) {
+    threshold_us_ = std::chrono::duration_cast<Micros>(threshold).count();
+    std::lock_guard<std::mutex> lock(log_mtx_);
+    if (log_) std::fclose(log_);
+    log_ = nullptr;
+    if (log_path.empty()) return;
+    log_ = std::fopen(log_path.c_str(), "a");
+    if (!log_) std::cerr << "[WARN] Cannot open slow query log " << log_path << ": " << std::strerror(errno) << std::endl;
+}
+
+void QueryStats::record(std::string_view name, Micros elapsed, uint64_t rows, Micros wait, bool error) {
+    auto it = index_.find(name);
+    if (it == index_.end()) return;
+    Cell &cell = cells_[it->second];
+    auto us = static_cast<uint64_t>(elapsed.count());
+
+    cell.calls.fetch_add(1, std::memory_order_relaxed);
+    if (error) cell.errors.fetch_add(1, std::memory_order_relaxed);
+    cell.rows.fetch_add(rows, std::memory_order_relaxed);
+    cell.total_us.fetch_add(us, std::memory_order_relaxed);
+    cell.wait_us.fetch_add(static_cast<uint64_t>(wait.count()), std::memory_order_relaxed);
+    if (isSlow(elapsed)) cell.slow.fetch_add(1, std::memory_order_relaxed);
+    for (uint64_t max = cell.max_us.load(std::memory_order_relaxed);
+         us > max && !cell.max_us.compare_exchange_weak(max, us, std::memory_order_relaxed);) {
+    }
+}
+
+bool QueryStats::isSlow(Micros elapsed) const {
+    int64_t threshold = threshold_us_.load(std::memory_order_relaxed);
+    return threshold > 0 && elapsed.count() >= threshold;
+}
+
+// Строка журнала: время, запрос, длительность, строки, ожидание соединения, описания параметров
+void QueryStats::logSlow(std::string_view name, Micros elapsed, uint64_t rows, Micros wait, const std::vector<std::string> &params) {
+    std::time_t now = std::time(nullptr);
+    std::tm tm{};
+    localtime_r(&now, &tm);
+    char when[32];
+    std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm);
+
+    std::ostringstream line;
+    line << when << " [SLOW] " << name << ' ' << elapsed.count() / 1000.0 << " ms, rows=" << rows
+         << ", wait=" << wait.count() / 1000.0 << " ms";
+    for (size_t i = 0; i < params.size(); ++i) line << (i ? " " : ", params: ") << '$' << i + 1 << '=' << params[i];
+    line << '\n';
+
+    std::lock_guard<std::mutex> lock(log_mtx_);
+    if (log_) {
+        std::fputs(line.str().c_str(), log_);
+        std::fflush(log_);
+    } else {
+        std::cerr << line.str() << std::flush;
+    }
+}
+
+std::vector<QueryStats::Row> QueryStats::snapshot() const {
+    std::vector<Row> rows;
+    rows.reserve(names_.size());
+    for (size_t i = 0; i < names_.size(); ++i) {
+        const Cell &cell = cells_[i];
+        uint64_t calls = cell.calls.load(std::memory_order_relaxed);
+        if (!calls) continue;
+        rows.push_back({std::string(names_[i]), calls, cell.errors.load(std::memory_order_relaxed),
+                        cell.rows.load(std::memory_order_relaxed), cell.slow.load(std::memory_order_relaxed),
+                        Micros(cell.total_us.load(std::memory_order_relaxed)), Micros(cell.max_us.load(std::memory_order_relaxed)),
+                        Micros(cell.wait_us.load(std::memory_order_relaxed))});
+    }
+    std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) { return a.total > b.total; });
+    return rows;
+}
+
+void QueryStats::reset() {
+    for (size_t i = 0; i < names_.size(); ++i) {
+        Cell &cell = cells_[i];
+        for (auto *counter : {&cell.calls, &cell.errors, &cell.rows, &cell.slow, &cell.total_us, &cell.max_us, &cell.wait_us})
+            counter->store(0, std::memory_order_relaxed);
+    }
+}
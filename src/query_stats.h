@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Счётчики по запросам каталога q:: (queries.sql) и журнал медленных запросов.
+// Пишут execQuery (pqxx) и AsyncConnection (libpq): число вызовов, ошибок, строк,
+// суммарное и наибольшее время, ожидание соединения пула перед запросом.
+// Таблица фиксирована при старте (один элемент на запрос), обновления — атомики без блокировок.
+class QueryStats {
+public:
+    using Micros = std::chrono::microseconds;
+
+    struct Row {
+        std::string name;
+        uint64_t calls, errors, rows, slow;
+        Micros total, max, wait;
+    };
+
+    // Общая на процесс таблица
+    static QueryStats &instance();
+
+    // Порог медленного запроса (0 — не писать журнал) и файл журнала (пусто — std::cerr)
+    void configure(std::chrono::milliseconds threshold, const std::string &log_path);
+
+    // wait — сколько вызывающий ждал соединение перед этим запросом. Имена вне каталога не считаются
+    void record(std::string_view name, Micros elapsed, uint64_t rows, Micros wait, bool error);
+    bool isSlow(Micros elapsed) const;
+    // params — уже обезличенные описания параметров (см. redactParam), не значения
+    void logSlow(std::string_view name, Micros elapsed, uint64_t rows, Micros wait, const std::vector<std::string> &params);
+
+    // По убыванию суммарного времени
+    std::vector<Row> snapshot() const;
+    void reset();
+
+private:
+    QueryStats();
+    ~QueryStats();
+
+    struct Cell {
+        std::atomic<uint64_t> calls{0}, errors{0}, rows{0}, slow{0};
+        std::atomic<uint64_t> total_us{0}, max_us{0}, wait_us{0};
+    };
+
+    std::vector<std::string_view> names_;
+    std::unique_ptr<Cell[]> cells_;
+    std::unordered_map<std::string_view, size_t> index_; // заполняется в конструкторе, дальше только чтение
+
+    std::atomic<int64_t> threshold_us_{200000};
+    std::mutex log_mtx_;
+    FILE *log_ = nullptr; // nullptr — std::cerr
+};
+
+// Описание параметра для журнала медленных запросов: тип и длина, без значения
+// (в параметрах бывают логины, хеши паролей, персональные данные)
+template <typename T>
+std::string redactParam(const T &value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        return "<bool>";
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        return "<number>";
+    } else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+        return "<text " + std::to_string(std::string_view(value).size()) + ">";
+    } else {
+        return "<?>";
+    }
+}
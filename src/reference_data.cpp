@@ -0,0 +1,189 @@
+#include "reference_data.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include "json_writer.h"
+#include "queries.h"
+
+static const std::string EMPTY_LIST = "[]";
+
+const std::string &ReferenceSnapshot::teacherCourses(int teacher_id) const {
+    auto it = teacherCoursesJson.find(teacher_id);
+    return it == teacherCoursesJson.end() ? EMPTY_LIST : it->second;
+}
+
+const std::string &ReferenceSnapshot::teacherGroups(int teacher_id, int course_id) const {
+    auto it = teacherGroupsJson.find(teacherCourseKey(teacher_id, course_id));
+    return it == teacherGroupsJson.end() ? EMPTY_LIST : it->second;
+}
+
+ReferenceData::ReferenceData(Database &db) : db_(db) {
+    // Без снимка сервер не стартует: ошибка здесь — исключение
+    std::atomic_store(&current_, load(1));
+    version_.store(1, std::memory_order_release);
+    rebuilder_ = std::thread([this] { rebuilder(); });
+}
+
+ReferenceData::~ReferenceData() {
+    {
+        std::lock_guard<std::mutex> lock(async_mtx_);
+        stopping_ = true;
+    }
+    async_cv_.notify_all();
+    rebuilder_.join();
+}
+
+std::shared_ptr<const ReferenceSnapshot> ReferenceData::get() const {
+    struct Cached {
+        const ReferenceData *owner = nullptr;
+        uint64_t version = 0;
+        std::shared_ptr<const ReferenceSnapshot> snapshot;
+    };
+    thread_local Cached cached;
+
+    uint64_t version = version_.load(std::memory_order_acquire);
+    if (cached.owner != this || cached.version != version) {
+        cached.snapshot = std::atomic_load(&current_);
+        cached.owner = this;
+        cached.version = cached.snapshot->version;
+    }
+    return cached.snapshot;
+}
+
+void ReferenceData::rebuild() {
+    std::lock_guard<std::mutex> lock(rebuild_mutex_);
+    try {
+        uint64_t next = version_.load(std::memory_order_relaxed) + 1;
+        std::atomic_store(&current_, load(next));
+        version_.store(next, std::memory_order_release);
+    } catch (const std::exception &e) {
+        std::cerr << "Reference data rebuild failed: " << e.what() << std::endl;
+    }
+}
+
+void ReferenceData::rebuildAsync(std::function<void()> done) {
+    {
+        std::lock_guard<std::mutex> lock(async_mtx_);
+        async_waiting_.push_back(std::move(done));
+    }
+    async_cv_.notify_one();
+}
+
+// Одна перестройка на всех, кто успел встать в очередь до её начала
+void ReferenceData::rebuilder() {
+    for (;;) {
+        std::vector<std::function<void()>> batch;
+        {
+            std::unique_lock<std::mutex> lock(async_mtx_);
+            async_cv_.wait(lock, [this] { return stopping_ || !async_waiting_.empty(); });
+            if (async_waiting_.empty()) return;
+            batch.swap(async_waiting_);
+        }
+        rebuild();
+        for (auto &done : batch) done();
+    }
+}
+
+crow::response ReferenceData::json(const std::string &body) {
+    crow::response res(200);
+    res.body = body;
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
+
+// Список {id, name} в готовый JSON
+template <typename Items, typename Id, typename Name>
+static std::string idNameList(const Items &items, Id id, Name name) {
+    JsonWriter w(64 + items.size() * 48);
+    w.beginArray();
+    for (auto &item : items) {
+        w.beginObject();
+        w.key("id").number(id(item));
+        w.key("name").string(name(item));
+        w.endObject();
+    }
+    w.endArray();
+    return w.take();
+}
+
+std::shared_ptr<const ReferenceSnapshot> ReferenceData::load(uint64_t version) {
+    auto snap = std::make_shared<ReferenceSnapshot>();
+    snap->version = version;
+
+    {
+        auto conn = db_.acquire();
+        pqxx::transaction<pqxx::repeatable_read, pqxx::read_only> txn(*conn);
+
+        for (auto row : execQuery(txn, q::get_all_courses))
+            snap->courses.push_back({row["id"].as<int>(), row["name"].as<std::string>()});
+
+        for (auto row : execQuery(txn, q::get_all_groups)) {
+            snap->groups.push_back({row["id"].as<int>(), row["name"].as<std::string>(),
+                                    row["student_count"].is_null() ? 0 : row["student_count"].as<int>()});
+        }
+
+        for (auto row : execQuery(txn, q::get_all_teacher_loads)) {
+            snap->loads.push_back({row["teacher_id"].as<int>(), row["course_id"].as<int>(), row["group_id"].as<int>(),
+                                   row["first_name"].as<std::string>(), row["last_name"].as<std::string>(),
+                                   row["course_name"].as<std::string>(), row["group_name"].as<std::string>()});
+        }
+        txn.commit();
+    }
+
+    for (auto &c : snap->courses) snap->courseNames.emplace(c.id, c.name);
+
+    snap->coursesJson = idNameList(snap->courses, [](const Course &c) { return c.id; },
+                                   [](const Course &c) -> const std::string & { return c.name; });
+
+    JsonWriter groups(64 + snap->groups.size() * 64);
+    groups.beginArray();
+    for (auto &g : snap->groups) {
+        groups.beginObject();
+        groups.key("id").number(g.id);
+        groups.key("name").string(g.name);
+        groups.key("student_count").number(g.student_count);
+        groups.endObject();
+    }
+    groups.endArray();
+    snap->groupsJson = groups.take();
+
+    JsonWriter loads(64 + snap->loads.size() * 160);
+    loads.beginArray();
+    for (auto &l : snap->loads) {
+        loads.beginObject();
+        loads.key("teacher_id").number(l.teacher_id);
+        loads.key("course_id").number(l.course_id);
+        loads.key("group_id").number(l.group_id);
+        loads.key("first_name").string(l.first_name);
+        loads.key("last_name").string(l.last_name);
+        loads.key("course_name").string(l.course_name);
+        loads.key("group_name").string(l.group_name);
+        loads.endObject();
+    }
+    loads.endArray();
+    snap->loadsJson = loads.take();
+
+    // Матрица нагрузки -> списки для преподавателя, в порядке get_teacher_courses /
+    // get_teacher_groups_for_course (по названию, предметы без повторов)
+    std::map<int, std::map<int, std::string>> coursesByTeacher;            // teacher -> course_id -> name
+    std::map<uint64_t, std::vector<const TeacherLoad *>> groupsByTeacherCourse;
+    for (auto &l : snap->loads) {
+        coursesByTeacher[l.teacher_id].emplace(l.course_id, l.course_name);
+        groupsByTeacherCourse[ReferenceSnapshot::teacherCourseKey(l.teacher_id, l.course_id)].push_back(&l);
+    }
+
+    for (auto &[teacher_id, byId] : coursesByTeacher) {
+        std::vector<std::pair<int, std::string>> list(byId.begin(), byId.end());
+        std::stable_sort(list.begin(), list.end(), [](auto &a, auto &b) { return a.second < b.second; });
+        snap->teacherCoursesJson.emplace(teacher_id, idNameList(list, [](auto &p) { return p.first; },
+                                                                [](auto &p) -> const std::string & { return p.second; }));
+    }
+
+    for (auto &[key, list] : groupsByTeacherCourse) {
+        std::stable_sort(list.begin(), list.end(), [](auto *a, auto *b) { return a->group_name < b->group_name; });
+        snap->teacherGroupsJson.emplace(key, idNameList(list, [](auto *l) { return l->group_id; },
+                                                        [](auto *l) -> const std::string & { return l->group_name; }));
+    }
+
+    return snap;
+}
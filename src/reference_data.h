@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <crow.h>
+#include "db.h"
+
+// группа со счётчиком студентов (для списка администратора)
+struct GroupInfo {
+    int id;
+    std::string name;
+    int student_count;
+};
+
+// нагрузка: преподаватель (users.id) ведёт предмет в группе
+struct TeacherLoad {
+    int teacher_id;
+    int course_id;
+    int group_id;
+    std::string first_name;
+    std::string last_name;
+    std::string course_name;
+    std::string group_name;
+};
+
+// Неизменяемый снимок справочников. JSON списков собирается один раз при построении.
+struct ReferenceSnapshot {
+    uint64_t version = 0;
+
+    std::vector<Course> courses;                      // по id
+    std::unordered_map<int, std::string> courseNames; // id -> название
+    std::vector<GroupInfo> groups;                    // по id
+    std::vector<TeacherLoad> loads;                   // по фамилии преподавателя, предмету
+
+    std::string coursesJson;
+    std::string groupsJson;
+    std::string loadsJson;
+    std::unordered_map<int, std::string> teacherCoursesJson;      // teacher_id -> [{id, name}]
+    std::unordered_map<uint64_t, std::string> teacherGroupsJson;  // (teacher_id, course_id) -> [{id, name}]
+
+    static uint64_t teacherCourseKey(int teacher_id, int course_id) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(teacher_id)) << 32) | static_cast<uint32_t>(course_id);
+    }
+
+    const std::string &teacherCourses(int teacher_id) const;
+    const std::string &teacherGroups(int teacher_id, int course_id) const;
+};
+
+// Справочники (предметы, группы, нагрузка teacher_courses) в памяти процесса.
+// Читатели берут текущий снимок без блокировок: в потоке хранится последний полученный
+// shared_ptr, и atomic_load выполняется только после смены версии.
+// Запись в БД идёт как обычно, затем rebuild() строит новый снимок и публикует его.
+class ReferenceData {
+public:
+    explicit ReferenceData(Database &db);
+    ~ReferenceData(); // дожидается запрошенных перестроек
+
+    ReferenceData(const ReferenceData &) = delete;
+    ReferenceData &operator=(const ReferenceData &) = delete;
+
+    std::shared_ptr<const ReferenceSnapshot> get() const;
+
+    // Перечитать справочники одной транзакцией и заменить снимок.
+    // Ошибка чтения логируется, прежний снимок остаётся.
+    void rebuild();
+
+    // rebuild() в собственном потоке ReferenceData — для IO-потоков, которым нельзя ждать БД.
+    // Запросы, пришедшие во время перестройки, объединяются в одну следующую.
+    // done вызывается в этом потоке после перестройки, начатой уже после запроса
+    void rebuildAsync(std::function<void()> done);
+
+    // Готовый JSON из снимка
+    static crow::response json(const std::string &body);
+
+private:
+    std::shared_ptr<const ReferenceSnapshot> load(uint64_t version);
+    void rebuilder();
+
+    Database &db_;
+    std::mutex rebuild_mutex_; // пишущие перестраивают по очереди, читатели его не трогают
+    std::shared_ptr<const ReferenceSnapshot> current_; // только через std::atomic_load / std::atomic_store
+    std::atomic<uint64_t> version_{0};
+
+    std::mutex async_mtx_;
+    std::condition_variable async_cv_;
+    std::vector<std::function<void()>> async_waiting_; // done ждущих следующей перестройки
+    bool stopping_ = false;
+    std::thread rebuilder_;
+};
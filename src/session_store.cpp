@@ -0,0 +1,96 @@
+#include "session_store.h"
+#include <algorithm>
+#include <openssl/rand.h>
+#include <stdexcept>
+#include "crypto.h"
+
+SessionStore::SessionStore(std::chrono::seconds ttl, size_t shards) : ttl_(ttl) {
+    shards_.reserve(std::max<size_t>(1, shards));
+    for (size_t i = 0; i < std::max<size_t>(1, shards); ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+        shards_.back()->next_sweep = Clock::now() + ttl_;
+    }
+}
+
+SessionStore::Shard &SessionStore::shardFor(const std::string &token) {
+    return *shards_[std::hash<std::string>{}(token) % shards_.size()];
+}
+
+// Вызывается под мьютексом шарда не чаще раза в ttl
+void SessionStore::sweepLocked(Shard &shard, Clock::time_point now) {
+    if (now < shard.next_sweep) return;
+    for (auto it = shard.sessions.begin(); it != shard.sessions.end();) {
+        if (it->second.expires <= now) it = shard.sessions.erase(it);
+        else ++it;
+    }
+    shard.next_sweep = now + ttl_;
+}
+
+std::string SessionStore::create(const Principal &principal) {
+    unsigned char bytes[32];
+    if (RAND_bytes(bytes, sizeof(bytes)) != 1) throw std::runtime_error("RAND_bytes failed");
+    std::string token = bytesToHex(bytes, sizeof(bytes));
+
+    auto now = Clock::now();
+    Shard &shard = shardFor(token);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    sweepLocked(shard, now);
+    shard.sessions[token] = Entry{principal, now + ttl_};
+    return token;
+}
+
+std::optional<Principal> SessionStore::find(const std::string &token) {
+    auto now = Clock::now();
+    Shard &shard = shardFor(token);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    sweepLocked(shard, now);
+
+    auto it = shard.sessions.find(token);
+    if (it == shard.sessions.end()) return std::nullopt;
+    if (it->second.expires <= now) {
+        shard.sessions.erase(it);
+        return std::nullopt;
+    }
+    it->second.expires = now + ttl_;
+    return it->second.principal;
+}
+
+void SessionStore::erase(const std::string &token) {
+    Shard &shard = shardFor(token);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.sessions.erase(token);
+}
+
+size_t SessionStore::eraseIf(const std::function<bool(const Principal &)> &pred) {
+    size_t erased = 0;
+    for (auto &shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (auto it = shard->sessions.begin(); it != shard->sessions.end();) {
+            if (pred(it->second.principal)) {
+                it = shard->sessions.erase(it);
+                ++erased;
+            } else {
+                ++it;
+            }
+        }
+    }
+    return erased;
+}
+
+size_t SessionStore::size() const {
+    size_t n = 0;
+    for (auto &shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        n += shard->sessions.size();
+    }
+    return n;
+}
+
+void SessionMiddleware::before_handle(crow::request &req, crow::response &, context &ctx) {
+    static const std::string BEARER = "Bearer ";
+    const std::string &auth = req.get_header_value("Authorization");
+    if (!store || auth.compare(0, BEARER.size(), BEARER) != 0) return;
+
+    ctx.token = auth.substr(BEARER.size());
+    ctx.principal = store->find(ctx.token);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <crow.h>
+
+// Кто выполняет запрос: всё, что обработчикам раньше приходилось доставать из БД по user_id
+struct Principal {
+    int user_id = -1;
+    std::string role;     // "ADMIN", "TEACHER", "STUDENT"
+    int student_id = -1;  // для STUDENT
+    int teacher_id = -1;  // teachers.id для TEACHER (если профиль есть)
+    int group_id = -1;    // группа студента
+};
+
+// Сессии в памяти: непрозрачный токен -> Principal.
+// Таблица разбита на шарды со своим мьютексом, так что запросы с разными токенами почти не
+// конкурируют. Срок жизни скользящий: каждое обращение продлевает сессию на ttl.
+// Просроченные записи удаляются при обращении и периодической чисткой шарда.
+class SessionStore {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit SessionStore(std::chrono::seconds ttl = std::chrono::hours(8), size_t shards = 32);
+
+    SessionStore(const SessionStore &) = delete;
+    SessionStore &operator=(const SessionStore &) = delete;
+
+    // Новая сессия; возвращает токен (64 hex-символа, 256 бит из RAND_bytes)
+    std::string create(const Principal &principal);
+    std::optional<Principal> find(const std::string &token);
+    void erase(const std::string &token);
+    // Сбросить сессии, чьи данные устарели (пользователь удалён, сменил роль или группу)
+    size_t eraseIf(const std::function<bool(const Principal &)> &pred);
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        Principal principal;
+        Clock::time_point expires;
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> sessions;
+        Clock::time_point next_sweep;
+    };
+
+    Shard &shardFor(const std::string &token);
+    void sweepLocked(Shard &shard, Clock::time_point now);
+
+    std::chrono::seconds ttl_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+// Заполняет контекст запроса сессией из заголовка "Authorization: Bearer <токен>".
+// Запрос без сессии не отклоняется: права проверяет обработчик (ctx.is("ADMIN")).
+struct SessionMiddleware {
+    SessionStore *store = nullptr; // задаётся в main до app.run()
+
+    struct context {
+        std::optional<Principal> principal;
+        std::string token;
+
+        bool is(const char *role) const { return principal && principal->role == role; }
+    };
+
+    void before_handle(crow::request &req, crow::response &res, context &ctx);
+    void after_handle(crow::request &, crow::response &, context &) {}
+};
@@ -0,0 +1,214 @@
+#include "static_cache.h"
+#include "crypto.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <openssl/evp.h>
+#include <zlib.h>
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// Долгий кеш для URL с хешем содержимого; остальное — всегда перепроверять по ETag
+static const char *IMMUTABLE_CACHE = "public, max-age=31536000, immutable";
+static const char *REVALIDATE_CACHE = "no-cache";
+
+static bool endsWith(const std::string &s, const std::string &suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static std::string contentType(const std::string &path) {
+    if (endsWith(path, ".html")) return "text/html; charset=utf-8";
+    if (endsWith(path, ".js")) return "application/javascript; charset=utf-8";
+    if (endsWith(path, ".css")) return "text/css; charset=utf-8";
+    if (endsWith(path, ".json")) return "application/json";
+    if (endsWith(path, ".svg")) return "image/svg+xml";
+    if (endsWith(path, ".png")) return "image/png";
+    if (endsWith(path, ".ico")) return "image/x-icon";
+    return "application/octet-stream";
+}
+
+static std::string contentHash(const std::string &data) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    EVP_Digest(data.data(), data.size(), digest, &len, EVP_sha256(), nullptr);
+    return bytesToHex(digest, 8);
+}
+
+static std::string gzipCompress(const std::string &data) {
+    z_stream zs{};
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) return "";
+
+    std::string out(deflateBound(&zs, data.size()), '\0');
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    zs.avail_in = data.size();
+    zs.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    zs.avail_out = out.size();
+    int rc = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return rc == Z_STREAM_END ? out : "";
+}
+
+static std::string brotliCompress(const std::string &data) {
+#ifdef HAVE_BROTLI
+    size_t size = BrotliEncoderMaxCompressedSize(data.size());
+    if (size == 0) return "";
+    std::string out(size, '\0');
+    if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                               data.size(), reinterpret_cast<const uint8_t *>(data.data()),
+                               &size, reinterpret_cast<uint8_t *>(&out[0]))) {
+        return "";
+    }
+    out.resize(size);
+    return out;
+#else
+    (void)data;
+    return "";
+#endif
+}
+
+static void finalize(StaticAsset &a) {
+    a.version = contentHash(a.body);
+    a.etag = "\"" + a.version + "\"";
+    a.gzip = gzipCompress(a.body);
+    if (a.gzip.size() >= a.body.size()) a.gzip.clear();
+    a.brotli = brotliCompress(a.body);
+    if (a.brotli.size() >= a.body.size()) a.brotli.clear();
+}
+
+static void replaceAll(std::string &s, const std::string &from, const std::string &to) {
+    for (size_t pos = s.find(from); pos != std::string::npos; pos = s.find(from, pos + to.size()))
+        s.replace(pos, from.size(), to);
+}
+
+StaticCache::StaticCache(std::string root) : root_(std::move(root)) {
+    std::atomic_store(&files_, load());
+}
+
+StaticCache::~StaticCache() {
+    stop_ = true;
+    if (watcher_.joinable()) watcher_.join();
+}
+
+std::shared_ptr<const StaticCache::Files> StaticCache::load() const {
+    auto files = std::make_shared<Files>();
+    if (!fs::is_directory(root_)) {
+        std::cerr << "[WARN] Static root " << root_ << " not found" << std::endl;
+        return files;
+    }
+
+    for (auto &entry : fs::recursive_directory_iterator(root_)) {
+        if (!entry.is_regular_file()) continue;
+        std::ifstream ifs(entry.path(), std::ios::binary);
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+
+        StaticAsset a;
+        a.content_type = contentType(entry.path().string());
+        a.body = ss.str();
+        (*files)[fs::relative(entry.path(), root_).generic_string()] = std::move(a);
+    }
+
+    // Сначала всё, кроме HTML: их хеши нужны для ссылок в HTML
+    for (auto &[path, a] : *files)
+        if (!endsWith(path, ".html")) finalize(a);
+
+    for (auto &[path, a] : *files) {
+        if (!endsWith(path, ".html")) continue;
+        for (auto &[dep, d] : *files) {
+            if (endsWith(dep, ".html")) continue;
+            std::string versioned = dep + "?v=" + d.version;
+            replaceAll(a.body, "src=\"" + dep + "\"", "src=\"/" + versioned + "\"");
+            replaceAll(a.body, "href=\"" + dep + "\"", "href=\"/" + versioned + "\"");
+        }
+        finalize(a);
+    }
+
+    std::cout << "[INFO] Static cache: " << files->size() << " files from " << root_ << std::endl;
+    return files;
+}
+
+// Совпадает ли ETag из If-None-Match (список через запятую, W/ и * допускаются)
+static bool etagMatches(const std::string &header, const std::string &etag) {
+    std::stringstream ss(header);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t b = item.find_first_not_of(" \t"), e = item.find_last_not_of(" \t");
+        if (b == std::string::npos) continue;
+        item = item.substr(b, e - b + 1);
+        if (item == "*") return true;
+        if (item.rfind("W/", 0) == 0) item = item.substr(2);
+        if (item == etag) return true;
+    }
+    return false;
+}
+
+crow::response StaticCache::serve(const crow::request &req, const std::string &path) const {
+    auto files = std::atomic_load(&files_);
+    auto it = files->find(path);
+    if (it == files->end()) return crow::response(404);
+    const StaticAsset &a = it->second;
+
+    // Выбор варианта по Accept-Encoding; у каждого варианта свой строгий ETag
+    const std::string &accept = req.get_header_value("Accept-Encoding");
+    const std::string *body = &a.body;
+    std::string encoding, etag = a.etag;
+    if (!a.brotli.empty() && accept.find("br") != std::string::npos) {
+        body = &a.brotli;
+        encoding = "br";
+        etag = "\"" + a.version + "-br\"";
+    } else if (!a.gzip.empty() && accept.find("gzip") != std::string::npos) {
+        body = &a.gzip;
+        encoding = "gzip";
+        etag = "\"" + a.version + "-gz\"";
+    }
+
+    const char *v = req.url_params.get("v");
+    bool immutable = v && a.version == v;
+
+    crow::response res;
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", immutable ? IMMUTABLE_CACHE : REVALIDATE_CACHE);
+    res.set_header("Vary", "Accept-Encoding");
+
+    if (etagMatches(req.get_header_value("If-None-Match"), etag)) {
+        res.code = 304;
+        return res;
+    }
+
+    res.body = *body;
+    res.set_header("Content-Type", a.content_type);
+    if (!encoding.empty()) res.set_header("Content-Encoding", encoding);
+    return res;
+}
+
+std::string StaticCache::fingerprint() const {
+    std::string fp;
+    std::error_code ec;
+    for (auto &entry : fs::recursive_directory_iterator(root_, ec)) {
+        if (!entry.is_regular_file(ec)) continue;
+        fp += entry.path().string() + ":" + std::to_string(entry.file_size(ec)) + ":" +
+              std::to_string(entry.last_write_time(ec).time_since_epoch().count()) + ";";
+    }
+    return fp;
+}
+
+void StaticCache::startWatcher(std::chrono::milliseconds interval) {
+    if (watcher_.joinable()) return;
+    watcher_ = std::thread([this, interval] {
+        std::string last = fingerprint();
+        while (!stop_) {
+            std::this_thread::sleep_for(interval);
+            std::string now = fingerprint();
+            if (now == last) continue;
+            last = now;
+            // Новый снимок подменяет старый целиком; текущие запросы дочитывают старый
+            std::atomic_store(&files_, load());
+        }
+    });
+    std::cout << "[INFO] Static cache watcher enabled" << std::endl;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <crow.h>
+
+// Файл из web/, загруженный в память один раз
+struct StaticAsset {
+    std::string content_type;
+    std::string body;     // как есть
+    std::string gzip;     // пусто, если сжатие не выгодно
+    std::string brotli;   // пусто, если сжатие не выгодно или brotli не собран
+    std::string version;  // короткий хеш содержимого (для ?v=)
+    std::string etag;     // строгий ETag несжатого варианта
+};
+
+// Кеш статики: весь каталог web/ в неизменяемых буферах.
+// HTML переписывается так, что ссылки на js/css содержат ?v=<хеш>, и такие URL
+// отдаются с долгим Cache-Control: immutable. Остальное — с ETag и If-None-Match -> 304.
+class StaticCache {
+public:
+    using Files = std::unordered_map<std::string, StaticAsset>;
+
+    explicit StaticCache(std::string root);
+    ~StaticCache();
+
+    StaticCache(const StaticCache &) = delete;
+    StaticCache &operator=(const StaticCache &) = delete;
+
+    // path относительно web/, например "js/api.js"
+    crow::response serve(const crow::request &req, const std::string &path) const;
+
+    // Для разработки: перечитывать web/ при изменении файлов (опрос mtime)
+    void startWatcher(std::chrono::milliseconds interval = std::chrono::seconds(1));
+
+private:
+    std::shared_ptr<const Files> load() const;
+    std::string fingerprint() const; // сумма mtime/размеров всех файлов
+
+    std::string root_;
+    std::shared_ptr<const Files> files_; // только через std::atomic_load / std::atomic_store
+
+    std::atomic<bool> stop_{false};
+    std::thread watcher_;
+};
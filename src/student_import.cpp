@@ -0,0 +1,127 @@
+#include "student_import.h"
+#include "crypto.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_set>
+
+// Разбор одной строки CSV: поля через запятую, кавычки "..." с удвоением "" внутри
+static std::vector<std::string> splitCsvLine(const std::string &line) {
+    std::vector<std::string> fields;
+    std::string field;
+    bool quoted = false;
+
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else if (c != '\r') {
+            field += c;
+        }
+    }
+    fields.push_back(field);
+    return fields;
+}
+
+std::vector<StudentImportRow> parseStudentCsv(std::istream &in, std::vector<std::string> &errors) {
+    std::vector<StudentImportRow> rows;
+    std::string line;
+    size_t line_no = 0;
+
+    while (std::getline(in, line)) {
+        ++line_no;
+        if (line.empty() || line == "\r") continue;
+
+        auto f = splitCsvLine(line);
+        if (line_no == 1 && !f.empty() && f[0] == "login") continue; // заголовок
+
+        if (f.size() != 6) {
+            errors.push_back("строка " + std::to_string(line_no) + ": ожидается 6 полей, получено " + std::to_string(f.size()));
+            continue;
+        }
+        if (f[0].empty() || f[1].empty()) {
+            errors.push_back("строка " + std::to_string(line_no) + ": пустой логин или пароль");
+            continue;
+        }
+        rows.push_back({f[0], f[1], f[2], f[3], f[4], f[5]});
+    }
+    return rows;
+}
+
+std::vector<std::string> hashPasswordsParallel(const std::vector<std::string> &passwords, const ImportProgress &progress) {
+    const size_t n = passwords.size();
+    std::vector<std::string> hashes(n);
+    if (n == 0) return hashes;
+
+    // Пачка — кратна ширине AVX-512, чтобы дорожки SIMD были заняты полностью
+    const size_t chunk = 64;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, (n + chunk - 1) / chunk);
+
+    std::atomic<size_t> next{0}, done{0};
+    auto worker = [&]() {
+        for (;;) {
+            size_t begin = next.fetch_add(chunk);
+            if (begin >= n) return;
+            size_t end = std::min(begin + chunk, n);
+
+            std::vector<std::string> part(passwords.begin() + begin, passwords.begin() + end);
+            auto part_hashes = hashPasswords(part);
+            std::move(part_hashes.begin(), part_hashes.end(), hashes.begin() + begin);
+
+            size_t total_done = done.fetch_add(end - begin) + (end - begin);
+            if (progress) progress("hash", total_done, n);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < threads; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool) t.join();
+    return hashes;
+}
+
+StudentImportResult importStudentsCsv(Database &db, std::istream &in, const ImportProgress &progress) {
+    StudentImportResult result;
+
+    auto parsed = parseStudentCsv(in, result.errors);
+    result.rows = parsed.size() + result.errors.size();
+
+    // Повтор логина внутри файла: оставляем первую строку
+    std::vector<StudentImportRow> rows;
+    rows.reserve(parsed.size());
+    std::unordered_set<std::string> seen;
+    for (auto &r : parsed) {
+        if (seen.insert(r.login).second) rows.push_back(std::move(r));
+        else ++result.duplicates_in_file;
+    }
+    if (progress) progress("parse", rows.size(), rows.size());
+    if (rows.empty()) return result;
+
+    std::vector<std::string> passwords;
+    passwords.reserve(rows.size());
+    for (auto &r : rows) passwords.push_back(r.password);
+    auto hashes = hashPasswordsParallel(passwords, progress);
+
+    auto stats = db.importStudents(rows, hashes, [&](size_t copied) {
+        if (progress) progress("copy", copied, rows.size());
+    });
+    if (progress) progress("merge", stats.inserted, rows.size());
+
+    result.inserted = stats.inserted;
+    result.skipped_existing = stats.skipped_existing;
+    result.without_group = stats.without_group;
+    return result;
+}
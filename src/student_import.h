@@ -0,0 +1,30 @@
+#pragma once
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+#include "db.h"
+
+// Импорт студентов из CSV:
+//   login,password,first_name,last_name,dob,group
+// group — название группы или её id; строка заголовка (начинается с "login") пропускается.
+
+// Прогресс: этап ("parse", "hash", "copy", "merge"), сделано, всего
+using ImportProgress = std::function<void(const std::string &stage, size_t done, size_t total)>;
+
+struct StudentImportResult {
+    size_t rows = 0;               // строк данных в файле
+    size_t inserted = 0;           // создано студентов
+    size_t skipped_existing = 0;   // логин уже есть в БД
+    size_t duplicates_in_file = 0; // повтор логина внутри файла
+    size_t without_group = 0;      // группа не найдена, студент создан без группы
+    std::vector<std::string> errors; // ошибки разбора ("строка N: ...")
+};
+
+std::vector<StudentImportRow> parseStudentCsv(std::istream &in, std::vector<std::string> &errors);
+
+// Хеширование на всех ядрах: каждый поток считает свою часть пачками SIMD (hashPasswords)
+std::vector<std::string> hashPasswordsParallel(const std::vector<std::string> &passwords, const ImportProgress &progress);
+
+// Полный цикл: разбор -> хеширование -> COPY во временную таблицу -> слияние в users/students
+StudentImportResult importStudentsCsv(Database &db, std::istream &in, const ImportProgress &progress = nullptr);
@@ -1,8 +1,33 @@
-// adminUsers
-async function fetchUsers() {
-    return await apiFetch("/admin/users", { method: "GET" });
+// Постраничные таблицы: сервер отдаёт {items, next_after_id}, следующая страница — по кнопке
+const PAGE_SIZE = 50;
+const pageCursors = {}; // id tbody -> next_after_id
+
+async function renderPagedTable(tableId, url, rowHtml, append = false) {
+    const table = document.getElementById(tableId);
+    if (!table) return;
+
+    const after = append ? pageCursors[tableId] : 0;
+    const page = await apiFetch(`${url}?after_id=${after}&limit=${PAGE_SIZE}`, { method: "GET" });
+    if (!page || page.error) { alert(page ? page.error : "Сервер вернул пустой ответ"); return; }
+
+    if (!append) table.innerHTML = "";
+    table.insertAdjacentHTML("beforeend", page.items.map(rowHtml).join(""));
+    pageCursors[tableId] = page.next_after_id;
+
+    // Кнопка "Показать ещё" под таблицей
+    let more = document.getElementById(tableId + "More");
+    if (!more) {
+        more = document.createElement("button");
+        more.id = tableId + "More";
+        more.textContent = "Показать ещё";
+        more.addEventListener("click", () => renderPagedTable(tableId, url, rowHtml, true));
+        table.closest("table").after(more);
+    }
+    more.style.display = page.next_after_id === null ? "none" : "";
 }
 
+// adminUsers
+
 async function createUser(login, password, role, first_name = "", last_name = "") {
     return await apiFetch("/admin/users", {
         method: "POST",
@@ -26,19 +51,9 @@ async function updateUser(id, login, role, first_name, last_name) {
     else renderUsers();
 }
 
-async function renderUsers() {
-    const users = await fetchUsers(); // Получаем тот самый JSON, что ты скинул
-    if (users.error) { alert(users.error); return; }
-
-    const table = document.getElementById("usersTable");
-    if (!table) return;
-
-    table.innerHTML = ""; // Очищаем таблицу перед рендером
-    users.forEach(user => {
-        const row = document.createElement("tr");
-        
-        // Формируем строку. 
-        row.innerHTML = `
+function userRowHtml(user) {
+    return `
+        <tr>
             <td>${user.id}</td>
             <td>${user.first_name || ""} ${user.last_name || ""}</td>
             <td>${user.login}</td>
@@ -53,9 +68,12 @@ async function renderUsers() {
                     Удалить
                 </button>
             </td>
-        `;
-        table.appendChild(row);
-    });
+        </tr>
+    `;
+}
+
+async function renderUsers() {
+    await renderPagedTable("usersTable", "/admin/users", userRowHtml);
 }
 
 
@@ -99,10 +117,6 @@ async function renderCourses() {
 
 
 // adminStudents
-async function fetchStudents() {
-    return await apiFetch("/admin/students", { method: "GET" });
-}
-
 async function createStudentProfile(first_name, last_name, dob, group_id, login, password) {
     const res = await apiFetch("/admin/students", {
         method: "POST",
@@ -120,37 +134,22 @@ async function deleteStudent(id) {
     else renderStudents();
 }
 
-    async function renderStudents() {
-        const students = await fetchStudents();
-
-        // Исправляем: сначала проверяем, что students вообще существует
-        if (!students) {
-            console.error("Сервер вернул null вместо списка студентов");
-            return;
-        }
-        if (students.error) { 
-            alert(students.error); 
-            return; 
-        }
+function studentRowHtml(student) {
+    return `
+        <tr>
+            <td>${student.id}</td>
+            <td>${student.first_name || ""}</td>
+            <td>${student.last_name || ""}</td> 
+            <td>${student.login || "—"}</td>     
+            <td>${student.dob || ""}</td>
+            <td>${student.group_id || ""}</td> <td><button onclick="deleteStudent(${student.id})">Удалить</button></td>
+        </tr>
+    `;
+}
 
-        const table = document.getElementById("studentsTable");
-        if (!table) return;
-
-        table.innerHTML = "";
-        students.forEach(student => {
-            const row = document.createElement("tr");
-            // Внутри students.forEach(student => { ... })
-            row.innerHTML = `
-                <td>${student.id}</td>
-                <td>${student.first_name || ""}</td>
-                <td>${student.last_name || ""}</td> 
-                <td>${student.login || "—"}</td>     
-                <td>${student.dob || ""}</td>
-                <td>${student.group_id || ""}</td> <td><button onclick="deleteStudent(${student.id})">Удалить</button></td>
-            `; 
-            table.appendChild(row);
-        });
-    }
+async function renderStudents() {
+    await renderPagedTable("studentsTable", "/admin/students", studentRowHtml);
+}
 
 async function updateStudent(id, first_name, last_name, dob, group_id) {
     const res = await apiFetch(`/admin/students/${id}/profile`, {
@@ -308,32 +307,31 @@ function editTeacher(id, first_name, last_name, login, group_ids) {
     }
 }
 
+function teacherRowHtml(t) {
+    return `
+        <tr>
+            <td>${t.id}</td>
+            <td>${t.first_name}</td>
+            <td>${t.last_name}</td>
+            <td>${t.login}</td>
+            <td>${t.groups}</td> <!-- ВЫВОДИМ ГРУППЫ ЗДЕСЬ -->
+            <td>
+                <button onclick="deleteTeacher(${t.id})" style="color:white">Удалить</button>
+            </td>
+        </tr>
+    `;
+}
+
 async function renderTeachers() {
     try {
-        const [teachers, courses, groups, loads] = await Promise.all([
-            apiFetch("/admin/teachers"),
+        const [courses, groups, loads] = await Promise.all([
             apiFetch("/admin/courses"),
             apiFetch("/admin/groups"),
             apiFetch("/admin/teachers/load")
         ]);
 
-        // Таблица списка преподавателей
-        const listTable = document.getElementById("teachersListTable"); 
-        
-        if (listTable && teachers && !teachers.error) {
-            listTable.innerHTML = teachers.map(t => `
-                <tr>
-                    <td>${t.id}</td>
-                    <td>${t.first_name}</td>
-                    <td>${t.last_name}</td>
-                    <td>${t.login}</td>
-                    <td>${t.groups}</td> <!-- ВЫВОДИМ ГРУППЫ ЗДЕСЬ -->
-                    <td>
-                        <button onclick="deleteTeacher(${t.id})" style="color:white">Удалить</button>
-                    </td>
-                </tr>
-            `).join("");
-        }
+        // Таблица списка преподавателей (постранично)
+        await renderPagedTable("teachersListTable", "/admin/teachers", teacherRowHtml);
 
         // Таблица нагрузки
         const loadTableBody = document.getElementById("teachersLoadList");
@@ -359,9 +357,7 @@ async function renderTeachers() {
         const cSelect = document.getElementById("loadCourseSelect");
         const gSelect = document.getElementById("loadGroupSelect");
 
-        if (teachers && tSelect) {
-            tSelect.innerHTML = teachers.map(t => `<option value="${t.id}">${t.last_name} ${t.first_name}</option>`).join("");
-        }
+        if (tSelect) await renderTeacherSelect(tSelect);
         if (courses && cSelect) {
             cSelect.innerHTML = courses.map(c => `<option value="${c.id}">${c.name}</option>`).join("");
         }
@@ -387,6 +383,31 @@ async function renderTeachers() {
 }
 
 
+// Выбор преподавателя для нагрузки — теми же страницами, что и таблица; последний пункт догружает следующую
+async function renderTeacherSelect(select, append = false) {
+    const after = append ? pageCursors[select.id] : 0;
+    const page = await apiFetch(`/admin/teachers?after_id=${after}&limit=${PAGE_SIZE}`, { method: "GET" });
+    if (!page || page.error) return;
+
+    const more = select.querySelector('option[value="more"]');
+    if (more) more.remove();
+    if (!append) select.innerHTML = "";
+    select.insertAdjacentHTML("beforeend",
+        page.items.map(t => `<option value="${t.id}">${t.last_name} ${t.first_name}</option>`).join(""));
+    pageCursors[select.id] = page.next_after_id;
+    if (page.next_after_id !== null) select.insertAdjacentHTML("beforeend", `<option value="more">Показать ещё…</option>`);
+
+    if (!select.dataset.paged) {
+        select.dataset.paged = "1";
+        select.addEventListener("change", async () => {
+            if (select.value !== "more") return;
+            const count = select.options.length - 1;
+            await renderTeacherSelect(select, true);
+            select.selectedIndex = Math.min(count, select.options.length - 1); // первый из догруженных
+        });
+    }
+}
+
 async function deleteLoad(tId, cId, gId) {
     if (!confirm("Удалить эту нагрузку у преподавателя?")) return;
     
@@ -396,8 +417,10 @@ async function deleteLoad(tId, cId, gId) {
 }
 
 async function assignTeacherLoad() {
+    const teacher = document.getElementById("loadTeacherSelect").value;
+    if (teacher === "more") { alert("Выберите преподавателя"); return; }
     const data = {
-        teacher_id: parseInt(document.getElementById("loadTeacherSelect").value),
+        teacher_id: parseInt(teacher),
         course_id: parseInt(document.getElementById("loadCourseSelect").value),
         group_id: parseInt(document.getElementById("loadGroupSelect").value)
     };
@@ -1,12 +1,11 @@
 async function apiFetch(url, opts = {}) {
-    const role = sessionStorage.getItem("role") || "";
-    const userId = sessionStorage.getItem("userId") || "";
+    // Сервер определяет пользователя по токену сессии из /login
+    const token = sessionStorage.getItem("token");
 
     opts.headers = {
         ...(opts.headers || {}),
         "Content-Type": "application/json",
-        "role": role,
-        "user_id": userId
+        ...(token ? { "Authorization": `Bearer ${token}` } : {})
     };
 
     try {
@@ -45,7 +44,12 @@ async function apiFetch(url, opts = {}) {
     }
 }
 
-
+// Закрыть сессию на сервере и очистить локальное состояние
+async function logout() {
+    await apiFetch("/logout", { method: "POST" });
+    sessionStorage.clear();
+    window.location.href = "/";
+}
 
 
 // Пользователи 
@@ -17,6 +17,7 @@ document.addEventListener("DOMContentLoaded", () => {
         console.log("LOGIN RESPONSE:", res);
 
         if (res.status === "success") {
+            sessionStorage.setItem("token", res.token);
             sessionStorage.setItem("role", res.role);
             console.log(res); 
             sessionStorage.setItem("userId", res.id ?? res.user_id ?? res.userId);
@@ -26,11 +26,6 @@ function checkAuth() {
     }
 }
 
-function logout() {
-    sessionStorage.clear();
-    window.location.href = "/";
-}
-
 // Журнал
 async function loadCourses() {
     const teacherId = sessionStorage.getItem("userId");